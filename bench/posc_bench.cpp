@@ -0,0 +1,166 @@
+// Samples per second of the per-sample loops of Core1 on one host core, every loop runs over a 100000-sample frame
+// of a noisy sine that crosses the trigger level every 1000 samples
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+
+#include "posc_calibration.hpp"
+#include "posc_decimator.hpp"
+#include "posc_packed.hpp"
+#include "posc_trigger.hpp"
+
+namespace {
+
+constexpr size_t frame_samples{100000};
+constexpr size_t sine_period{1000};
+constexpr int runs{50};
+
+uint16_t frame_u16[frame_samples];
+uint8_t frame_u8[frame_samples];
+uint16_t output_u16[frame_samples];
+uint8_t frame_packed[dsp::get_packed12_bytes(frame_samples)];
+
+// Sink of the results, so no loop is optimized away
+volatile size_t result_sink;
+
+void fill_frames() {
+    uint32_t noise{1};
+    for (size_t i{0}; i < frame_samples; ++i) {
+        noise = noise * 1664525U + 1013904223U;
+        const float sine{sinf(6.2831853f * static_cast<float>(i) / sine_period)};
+        const int32_t sample{static_cast<int32_t>(2048.0f + 1800.0f * sine) + static_cast<int32_t>(noise >> 28) - 8};
+        frame_u16[i] = static_cast<uint16_t>(sample);
+        frame_u8[i] = static_cast<uint8_t>(sample >> 4);
+    }
+}
+
+// Fastest of the runs, the others are slowed down by the host, next to it the result of the run (triggers found, samples written)
+template <typename RUN>
+void report(const char *name, RUN &&run) {
+    double best_s{1e9};
+    for (int i{0}; i < runs; ++i) {
+        const auto start{std::chrono::steady_clock::now()};
+        result_sink = run();
+        const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+        if (elapsed.count() < best_s) best_s = elapsed.count();
+    }
+    printf("%-24s %10.1f MS/s %8zu\n", name, frame_samples / best_s / 1e6, static_cast<size_t>(result_sink));
+}
+
+// Every trigger of the frame is found, the scan continues after it like the scan of the next block
+template <typename T>
+size_t scan_frame(const trig::Settings &settings, const T *frame) {
+    trig::BlockScanner scanner;
+    scanner.set_channels(1, 0);
+    scanner.reset(settings, 0, 1, adc::max_samplerate);
+    size_t triggers{0};
+    while (scanner.scan(frame, frame_samples) != trig::BlockScanner::no_trigger) {
+        ++triggers;
+    }
+    return triggers;
+}
+
+template <typename T>
+void report_scan(const char *name, trig::Settings settings, const T *frame) {
+    settings.set_sampling_size(sizeof(T) == 1 ? adc::sampling_size_t::U8 : adc::sampling_size_t::U12);
+    report(name, [&]() { return scan_frame(settings, frame); });
+}
+
+// Input of the channels is interleaved in the round robin order, every channel gets frame_samples / channels of the frame
+void report_decimation(const char *name, uint32_t factor, size_t channels) {
+    dsp::BoxcarDecimator decimator;
+    report(name, [&]() {
+        decimator.reset(factor, channels);
+        size_t output_count;
+        decimator.process(frame_u16, frame_samples, output_u16, frame_samples, output_count);
+        return output_count;
+    });
+}
+
+// Table with the offset, gain and DNL errors of a typical RP2040, the same for every channel
+void report_correction(const char *name, uint32_t channel_mask) {
+    constexpr int16_t dnl[cal::dnl_steps]{104, 96, 112, 100};
+    cal::Table table;
+    for (cal::ChannelCorrection &correction : table.channels) {
+        correction = cal::calculate(210.0f, 3890.0f, 200.0f, 3900.0f, dnl);
+    }
+
+    cal::Corrector corrector;
+    size_t lanes{0};
+    for (uint32_t mask{channel_mask}; mask > 0; mask &= mask - 1) ++lanes;
+    report(name, [&]() {
+        corrector.reset(table, channel_mask, 0, lanes);
+        corrector.correct(frame_u16, output_u16, frame_samples);
+        return frame_samples;
+    });
+}
+
+}  // namespace
+
+int main() {
+    fill_frames();
+
+    trig::Settings edge;
+    edge.set_level_mV(1650);
+    report_scan("Edge scan u16", edge, frame_u16);
+    report_scan("Edge scan u8", edge, frame_u8);
+
+    // Hysteresis moves the edge trigger from the crossing scan to the state machine of the other types
+    trig::Settings hysteresis{edge};
+    hysteresis.set_hysteresis_mV(100);
+    report_scan("Hysteresis scan u16", hysteresis, frame_u16);
+    report_scan("Hysteresis scan u8", hysteresis, frame_u8);
+
+    // Pulses above the level last 1 ms at the 500 kS/s of the scanner
+    trig::Settings pulse{edge};
+    pulse.set_type(trig::Settings::Type::PULSE_WIDTH);
+    pulse.set_condition(trig::Settings::Condition::LONGER);
+    pulse.set_time_limits_us(500, 0);
+    report_scan("Pulse width scan u16", pulse, frame_u16);
+    report_scan("Pulse width scan u8", pulse, frame_u8);
+
+    // Sine enters the 1 V to 2.5 V window from below and from above in every period
+    trig::Settings window;
+    window.set_level_mV(1000);
+    window.set_type(trig::Settings::Type::WINDOW);
+    report_scan("Window scan u16", window, frame_u16);
+    report_scan("Window scan u8", window, frame_u8);
+
+    // Upper level is above the peaks of the sine, so every pulse is a runt
+    trig::Settings runt{window};
+    runt.set_type(trig::Settings::Type::RUNT);
+    runt.increment_upper_level(trig::Settings::max_voltage_mV);
+    report_scan("Runt scan u16", runt, frame_u16);
+    report_scan("Runt scan u8", runt, frame_u8);
+
+    // Sine rises from 1 V to 2.5 V in about 350 us
+    trig::Settings slope{window};
+    slope.set_type(trig::Settings::Type::SLOPE);
+    slope.set_condition(trig::Settings::Condition::SHORTER);
+    slope.set_time_limits_us(500, 0);
+    report_scan("Slope scan u16", slope, frame_u16);
+    report_scan("Slope scan u8", slope, frame_u8);
+
+    report_decimation("Decimation 1 ch x8", 8, 1);
+    report_decimation("Decimation 1 ch x64", 64, 1);
+    report_decimation("Decimation 4 ch x8", 8, 4);
+    report_decimation("Decimation 4 ch x64", 64, 4);
+
+    // Odd start index takes the path that completes a pair first, like the second block of a capture
+    report("Pack12 even start", []() {
+        dsp::pack12(frame_packed, 0, frame_u16, frame_samples);
+        return frame_samples;
+    });
+    report("Pack12 odd start", []() {
+        dsp::pack12(frame_packed, 1, frame_u16, frame_samples - 1);
+        return frame_samples - 1;
+    });
+    report("Unpack12", []() {
+        dsp::unpack12(dsp::Packed12View{frame_packed}, 0, output_u16, frame_samples);
+        return frame_samples;
+    });
+
+    report_correction("Correction 1 ch", 0b0001);
+    report_correction("Correction 4 ch", 0b1111);
+    return 0;
+}
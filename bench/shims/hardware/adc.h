@@ -0,0 +1,15 @@
+#pragma once
+// Host shim of the Pico SDK header, only what the headers of src/posc used by the bench need
+#include "pico/types.h"
+
+#define ADC_CS_START_ONCE_BITS 0x00000004u
+#define ADC_DIV_INT_BITS 0x00ffff00u
+#define ADC_DIV_INT_LSB 8u
+#define ADC_DIV_FRAC_BITS 0x000000ffu
+
+typedef struct {
+    io_rw_32 cs, result, fcs, fifo, div, intr, inte, intf, ints;
+} adc_hw_t;
+
+// Registers are never accessed by the bench
+#define adc_hw ((adc_hw_t *)nullptr)
@@ -0,0 +1,7 @@
+#pragma once
+// Host shim of the Pico SDK header, only what the headers of src/posc used by the bench need
+#include "pico/types.h"
+
+inline void hw_set_bits(io_rw_32 *addr, uint32_t mask) {
+    *addr |= mask;
+}
@@ -0,0 +1,9 @@
+#pragma once
+// Host shim of the Pico SDK header, only what the headers of src/posc used by the bench need
+#include "pico/types.h"
+
+enum clock_index { clk_gpout0, clk_gpout1, clk_gpout2, clk_gpout3, clk_ref, clk_sys, clk_peri, clk_usb, clk_adc, clk_rtc };
+
+inline uint32_t clock_get_hz(clock_index clk_index) {
+    return 48000000U;
+}
@@ -0,0 +1,16 @@
+#pragma once
+// Host shim of the Pico SDK header, only what the headers of src/posc used by the bench need
+#include <stddef.h>
+#include "pico/types.h"
+
+#define FLASH_PAGE_SIZE (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+#define XIP_BASE 0x10000000
+
+// Flash is never accessed by the bench
+inline void flash_range_erase(uint32_t flash_offs, size_t count) {
+}
+
+inline void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+}
@@ -0,0 +1,27 @@
+#pragma once
+// Host shim of the Pico SDK header, only what the headers of src/posc used by the bench need
+#include "pico/types.h"
+
+typedef void (*hardware_alarm_callback_t)(uint alarm_num);
+
+inline uint64_t time_us_64() {
+    return 0;
+}
+
+inline absolute_time_t from_us_since_boot(uint64_t us) {
+    return us;
+}
+
+inline int hardware_alarm_claim_unused(bool required) {
+    return 0;
+}
+
+inline void hardware_alarm_set_callback(uint alarm_num, hardware_alarm_callback_t callback) {
+}
+
+inline bool hardware_alarm_set_target(uint alarm_num, absolute_time_t t) {
+    return false;
+}
+
+inline void hardware_alarm_cancel(uint alarm_num) {
+}
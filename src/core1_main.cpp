@@ -1,16 +1,44 @@
 #include <stdint.h>
+#include <etl/algorithm.h>
 #include "core1_main.hpp"
 #include "hardware/address_mapped.h"
 #include "hardware/irq.h"
 #include "hardware/adc.h"
 #include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
 
 #include "posc_adc.hpp"
 #include "posc_dma.hpp"
+#include "posc_ets.hpp"
+#include "posc_decimator.hpp"
+#include "posc_averager.hpp"
+#include "posc_autoset.hpp"
+#include "posc_packed.hpp"
+#include "posc_calibration.hpp"
 
-uint16_t adc_buffer_u16[adc_buffer_size_u16];
+alignas(4) uint16_t adc_buffer_u16[adc_buffer_size_u16];
 constexpr void *adc_buffer_addr{adc_buffer_u16};
 
+// In hi-res mode DMA cycles over this buffer at full ADC rate and Core1 decimates it into the capture slot,
+// in packed mode Core1 packs it into the slot right behind DMA
+constexpr size_t hires_buffer_size{2048};
+constexpr size_t hires_chunks{4};
+alignas(4) uint16_t hires_buffer[hires_buffer_size];
+
+// Segment table of every capture slot, it stays valid as long as the samples of the slot, so frames only point to it
+FrameSegment frame_segments[CaptureSlots::max_slots][max_segments];
+
+// Autoset probes the trigger channel into the hi-res buffer, a slower probe follows when two periods did not fit
+constexpr float autoset_probe_samplerates[]{500000.0f, 50000.0f, 5000.0f};
+autoset::Measurement autoset_measurement;
+
+volatile cal::Step calibration_step{cal::Step::LOW};
+cal::Measurement calibration_measurement;
+volatile bool flash_write_pending{false};
+volatile uint32_t freeze_request_us{0};
+
 mutex_t datac1_mutex;
 DataForCore1 datac1_glob{&datac1_mutex};
 extern DataForCore0 datac0_glob;
@@ -21,41 +49,225 @@ debug_data_t debug_data;
 
 int dma_ctrl_chan;
 int dma_adc_chan;
-volatile bool ctrl_channel_trigered{false};
-volatile bool adc_chan_null_trigger{false};
-volatile bool dma_cycle_forever{false};
+// Chained from the control channel of the function generator, it starts the ADC at the start of a period
+int dma_sync_chan{-1};
+const uint32_t adc_start_many_bits{ADC_CS_START_MANY_BITS};
 
-volatile void *ctrl_chan_adc_write = adc_buffer_addr;
-volatile void **ctrk_chan_read_addr = &ctrl_chan_adc_write;
 io_rw_32 *ctrl_chan_write_addr;
+dma::ChunkRing dma_chunk_ring;
+// Mean of the last closed DC window, read by Core0 in modes without frames
+volatile float sniffed_dc_level{0.0f};
+// Time from publishing live settings by Core0 until Core1 used them
+volatile uint32_t settings_latency_us{0};
 
 void dma_irq_handler() {
     if (dma_channel_get_irq1_status(dma_ctrl_chan)) {
-        ctrl_channel_trigered = true;
-        if (!dma_cycle_forever) {
-            ctrl_chan_adc_write = 0;
-        }
+        dma_chunk_ring.chunk_started();
         dma_channel_acknowledge_irq1(dma_ctrl_chan);
+        // Wakes Core1 from WFE even when the interrupt was taken before it went to sleep
+        __sev();
     }
-    // if (dma_channel_get_irq1_status(dma_adc_chan)) {
-    //     adc_chan_null_trigger = true;
-    //     dma_channel_acknowledge_irq1(dma_adc_chan);
-    // }
+}
+
+// Samplerates below the ADC divider range start every conversion from an alarm on Core1
+adc::TimerPacing timer_pacing;
+
+void timer_pacing_handler(uint alarm_num) {
+    timer_pacing.handle_alarm();
+}
+
+// Edge of the external trigger input is timestamped by the samples DMA has written at that moment,
+// the trigger output goes high when a trigger is accepted until the end of the acquisition
+constexpr uint ext_trigger_pin{20}, trigger_out_pin{21};
+volatile bool ext_trigger_pending{false};
+volatile uint32_t ext_trigger_total{0}, ext_trigger_us{0};
+
+void ext_trigger_handler(uint gpio, uint32_t events) {
+    gpio_put(trigger_out_pin, true);
+    ext_trigger_total = dma_chunk_ring.get_current_total();
+    ext_trigger_us = time_us_32();
+    ext_trigger_pending = true;
+    // One edge per arming, Core1 arms the input again when the edge is not accepted
+    gpio_set_irq_enabled(ext_trigger_pin, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, false);
+    __sev();
 }
 
 void core1_main() {
-    DataForCore0 datac0_private;
+    // Frames and settings are kept in static storage, the stack of Core1 has only 2 KB
+    static DataForCore0 datac0_private;
+    static DataForCore1 datac1_private;
     trig::Settings triggersettings_private;
     constexpr uint adc0_pin{26}, adc1_pin{27}, adc2_pin{28}, adc3_pin{29};
-    bool adc_running, trigger_detected, adc_done;
-    uint32_t end_tx_count, pretring_tx_count, current_tx_count;
-    bool wait_for_next_cycle;
+    bool adc_running{false}, trigger_detected, adc_done;
+    uint32_t end_index, current_written, current_cycles, current_total;
+    bool wait_for_next_cycle, ring_cycling;
     uint32_t pretrig_samples, posttrig_samples, second_cycle_tx_count;
     uint32_t array_index;
-    uint32_t samples[2];
+    trig::BlockScanner scanner;
     core0_message c0msg{STOP_ADC};
-    uint32_t current_channel{0};
     size_t trigger_channel_index_div{1};
+    uint trigger_input{0};
+
+    // Ring of the slot that is being captured
+    void *ring_start{adc_buffer_u16};
+    uint32_t ring_size{adc_buffer_size_u16};
+    adc::sampling_size_t sampling_size{adc::sampling_size_t::U12};
+
+    // Capture runs again as soon as a slot is free until STOP_ADC or the end of a single capture
+    bool acquisition_active{false};
+    size_t capture_slot{CaptureSlots::none}, pending_slot{CaptureSlots::none}, published_slot{CaptureSlots::none};
+    CaptureSlots capture_slots;
+    static DataForCore0 pending_frame;
+    uint32_t capture_start_us{0}, capture_end_us{0}, idle_time_us{0};
+    bool previous_capture_valid{false};
+
+    // Segmented capture re-arms the trigger right after each segment until the slot is full
+    void *slot_start{adc_buffer_u16};
+    size_t segment_index{0}, number_of_segments{1};
+    uint32_t segment_size{adc_buffer_size_u16}, segment_start_us{0}, segment_dead_time_us{0};
+    uint64_t trigger_time_us{0}, last_trigger_us{0};
+
+    // Equivalent-time sampling repeats acquisitions into one slot until the fine grid is filled
+    uint32_t ets_factor{1};
+    size_t ets_points{0}, ets_attempts{0};
+    uint16_t *ets_output{nullptr};
+    ets::Reconstructor reconstructor;
+
+    // Averaging repeats triggered acquisitions into 32-bit sums placed in front of the ring
+    uint32_t average_count{1};
+    uint16_t *average_output{nullptr};
+    uint32_t *average_sums{nullptr};
+    dsp::FrameAverager averager;
+
+    // Hi-res mode fills the ring from the decimator instead of DMA
+    uint32_t hires_factor{1};
+    size_t hires_read_index{0}, hires_write_index{0};
+    dsp::BoxcarDecimator decimator;
+
+    // Packed capture goes through the hi-res buffer too, the ring holds two 12-bit samples in three bytes
+    bool packed{false};
+
+    // Core1 handles the capture once per complete DMA chunk and sleeps in between
+    uint32_t dma_chunk_size{dma_chunk_max_samples};
+
+    // Timer-paced capture runs the ADC conversion by conversion at conversion_rate
+    bool timer_paced{false};
+    float conversion_rate{adc::max_samplerate};
+
+    // Generator-synchronized capture has its trigger at the first sample, no trigger is searched
+    bool generator_sync{false};
+
+    // External trigger replaces the scan of the trigger channel
+    bool external_trigger{false};
+
+    uint32_t applied_settings_us{0};
+
+    // DMA sniffer sums every transferred sample, Core1 only divides the sum of a window by its length
+    uint32_t dc_window_sum{0}, dc_window_total{0}, dc_window_start_us{0};
+
+    // Roll and stream modes keep DMA cycling over the slot without trigger, Core0 follows the written samples
+    bool free_running{false};
+
+    // Flight recorder cycles over the whole slot without trigger until the stop event, the frame ends at the event
+    bool recording{false};
+
+    // Deep capture keeps only the pretrigger in the ring, the frame goes to Core0 at the trigger and DMA keeps cycling until its end
+    uint32_t deep_samples{0}, deep_end_total{0};
+
+    // DMA writes the hi-res buffer instead of the ring, Core1 moves its samples to the ring
+    auto is_staged = [&]() {
+        return hires_factor > 1 || packed;
+    };
+
+    auto arm_external_trigger = [&]() {
+        ext_trigger_pending = false;
+        gpio_put(trigger_out_pin, false);
+        const uint32_t edge_event{triggersettings_private.get_edge() == trig::Settings::Edge::RISING ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL};
+        gpio_set_irq_enabled(ext_trigger_pin, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, false);
+        if (external_trigger || recording) {
+            gpio_acknowledge_irq(ext_trigger_pin, edge_event);
+            gpio_set_irq_enabled(ext_trigger_pin, edge_event, true);
+        }
+    };
+
+    // External edge is found once its sample was written, the trigger point is the trigger channel sample of its round robin cycle
+    auto find_external_trigger = [&](uint32_t scan_end_index, uint32_t cycle_start_total) -> size_t {
+        if (!ext_trigger_pending) return trig::BlockScanner::no_trigger;
+        const uint32_t edge_total{ext_trigger_total};
+        const uint32_t trigger_total{static_cast<uint32_t>(edge_total - edge_total % trigger_channel_index_div)};
+        const uint32_t trigger_offset{trigger_total - cycle_start_total};
+        if (trigger_total < pretrig_samples || static_cast<int32_t>(trigger_offset) < 0) {
+            // Pretrigger was not sampled yet, the input is armed for the next edge
+            arm_external_trigger();
+            return trig::BlockScanner::no_trigger;
+        }
+        if (trigger_offset >= scan_end_index) return trig::BlockScanner::no_trigger;
+        ext_trigger_pending = false;
+        return trigger_offset;
+    };
+
+    // Cycle start is the sample counter of DMA at index 0 of the scanned ring cycle
+    auto scan_for_trigger = [&](uint32_t scan_end_index, uint32_t cycle_start_total) {
+#ifndef NDEBUG
+        const uint32_t scan_start_index = scanner.get_next_index();
+        const uint32_t scan_start_us = time_us_32();
+#endif
+        size_t trigger_index;
+        if (external_trigger) {
+            trigger_index = find_external_trigger(scan_end_index, cycle_start_total);
+        } else if (packed) {
+            trigger_index = scanner.scan(dsp::Packed12View{ring_start}, scan_end_index);
+        } else if (sampling_size == adc::sampling_size_t::U8) {
+            trigger_index = scanner.scan(static_cast<const uint8_t *>(ring_start), scan_end_index);
+        } else {
+            trigger_index = scanner.scan(static_cast<const uint16_t *>(ring_start), scan_end_index);
+        }
+#ifndef NDEBUG
+        debug_data.add_scan_time(scan_end_index > scan_start_index ? scan_end_index - scan_start_index : 0, time_us_32() - scan_start_us);
+#endif
+        if (trigger_index == trig::BlockScanner::no_trigger) return;
+
+        gpio_put(trigger_out_pin, true);
+        trigger_time_us = time_us_64();
+        last_trigger_us = trigger_time_us;
+        array_index = trigger_index;
+        if (deep_samples > 0) {
+            // Trigger sample was written before the last complete chunk, counter of DMA is derived from the distance to it
+            const uint32_t trigger_total{current_total - (current_written + ring_size - array_index) % ring_size};
+            datac0_private.deep_start_index = (array_index + ring_size - pretrig_samples) % ring_size;
+            datac0_private.deep_start_total = trigger_total - pretrig_samples;
+            datac0_private.trigger_index = pretrig_samples;
+            datac0_private.first_channel = (trigger_channel_index_div - pretrig_samples % trigger_channel_index_div) % trigger_channel_index_div;
+            datac0_private.set_array1(ring_start, ring_size, 0);
+            datac0_private.array2_start = ring_start;
+            datac0_private.capture_time_us = 0;
+            datac0_private.idle_time_us = 0;
+            deep_end_total = trigger_total + posttrig_samples;
+            pending_slot = capture_slot;
+            pending_frame = datac0_private;
+            trigger_detected = true;
+            return;
+        }
+        if (array_index + posttrig_samples > ring_size) {
+            second_cycle_tx_count = array_index + posttrig_samples - ring_size;
+            end_index = second_cycle_tx_count;
+#ifndef NDEBUG
+            debug_data.second_cycle = second_cycle_tx_count;
+#endif
+            wait_for_next_cycle = true;
+        } else {
+            end_index = array_index + posttrig_samples;
+        }
+        // DMA of hi-res and packed modes keeps cycling over its own buffer
+        if (!is_staged()) {
+            dma_chunk_ring.set_wraps(wait_for_next_cycle ? 1 : 0);
+        }
+        ring_cycling = false;
+        trigger_detected = true;
+#ifndef NDEBUG
+        debug_data.trigger_detected = true;
+#endif
+    };
 
     const int adc_chan = dma_claim_unused_channel(true);
     const int ctrl_chan = dma_claim_unused_channel(true);
@@ -66,13 +278,12 @@ void core1_main() {
     dma_ctrl_chan = ctrl_chan;
     dma_adc_chan = adc_chan;
     ctrl_chan_write_addr = &(dma_channel_hw_addr(adc_chan)->al2_write_addr_trig);
-    // void **const ctrl_read_addr = &ctrl_adc_addr;
 
     dma_channel_config ctrl_chan_cfg = dma_channel_get_default_config(ctrl_chan);
     channel_config_set_transfer_data_size(&ctrl_chan_cfg, DMA_SIZE_32);
     channel_config_set_read_increment(&ctrl_chan_cfg, false);
     channel_config_set_write_increment(&ctrl_chan_cfg, false);
-    dma_channel_configure(ctrl_chan, &ctrl_chan_cfg, ctrl_chan_write_addr, ctrk_chan_read_addr, 1, false);
+    dma_channel_configure(ctrl_chan, &ctrl_chan_cfg, ctrl_chan_write_addr, dma_chunk_ring.get_next_write_addr_source(), 1, false);
 
     dma_channel_config adc_chan_cfg = dma_channel_get_default_config(adc_chan);
     channel_config_set_irq_quiet(&adc_chan_cfg, true);
@@ -80,12 +291,26 @@ void core1_main() {
     channel_config_set_read_increment(&adc_chan_cfg, false);
     channel_config_set_write_increment(&adc_chan_cfg, true);
     channel_config_set_dreq(&adc_chan_cfg, DREQ_ADC);
+    channel_config_set_sniff_enable(&adc_chan_cfg, true);
     channel_config_set_chain_to(&adc_chan_cfg, ctrl_chan);
     dma_channel_configure(adc_chan, &adc_chan_cfg, adc_buffer_addr, &(adc_hw->fifo), adc_buffer_size_u16, false);
 
+    dma::enable_sum_sniffer(adc_chan);
+
+    const int sync_chan = dma_claim_unused_channel(true);
+    dma_channel_config sync_chan_cfg = dma_channel_get_default_config(sync_chan);
+    channel_config_set_transfer_data_size(&sync_chan_cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&sync_chan_cfg, false);
+    channel_config_set_write_increment(&sync_chan_cfg, false);
+    channel_config_set_enable(&sync_chan_cfg, false);
+    dma_channel_configure(sync_chan, &sync_chan_cfg, hw_set_alias_untyped(&adc_hw->cs), &adc_start_many_bits, 1, false);
+    dma_sync_chan = sync_chan;
     dma_channel_set_irq1_enabled(ctrl_chan, true);
     irq_set_exclusive_handler(DMA_IRQ_1, dma_irq_handler);
     irq_set_enabled(DMA_IRQ_1, true);
+    // Lockout handler takes every word of the FIFO, so it is enabled only while Core0 writes the flash
+    multicore_lockout_victim_init();
+    irq_set_enabled(SIO_IRQ_PROC1, false);
 
     adc_init();
     adc_gpio_init(adc0_pin);
@@ -95,192 +320,847 @@ void core1_main() {
     adc_select_input(0);
     adc_set_round_robin(0);
     adc_set_clkdiv(0.0f);
+    timer_pacing.init(timer_pacing_handler);
 
-    send_msg_to_core0(CORE1_STARTED);
-
-    while (true) {
-        /*
-         * Handle messages from Core0
-         */
-        if (fifo_contains_value()) {
-            core0_message c0msg = get_msg_from_core0();
-            if (c0msg == START_ADC_AUTO || c0msg == START_ADC_SINGLE) {
-                if (adc_running) {
-                    adc_run(false);
-                    dma_channel_abort(adc_chan);
-                    adc_running = false;
-                }
-                adc_init();
-                datac1_glob.lock_blocking();
-
-                triggersettings_private = datac1_glob.trigger_settings;
+    gpio_init(trigger_out_pin);
+    gpio_set_dir(trigger_out_pin, true);
+    gpio_put(trigger_out_pin, false);
+    gpio_init(ext_trigger_pin);
+    gpio_pull_down(ext_trigger_pin);
+    // Interrupt of the GPIO bank is enabled on this core
+    gpio_set_irq_enabled_with_callback(ext_trigger_pin, GPIO_IRQ_EDGE_RISE, false, ext_trigger_handler);
 
-                end_tx_count = adc_buffer_size_u16 - datac1_glob.number_of_samples;
-                pretrig_samples = triggersettings_private.calculate_pretrig_count(datac1_glob.number_of_samples);
-                posttrig_samples = datac1_glob.number_of_samples - pretrig_samples;
-                pretring_tx_count = adc_buffer_size_u16 - pretrig_samples;
-                current_tx_count = adc_buffer_size_u16;
+    // Packed sample is addressed by the pair of bytes it shares with its neighbour
+    auto get_ring_sample = [&](uint32_t index) -> void * {
+        const size_t offset{packed ? (index / 2) * 3 : index * get_bytes_per_sample(sampling_size)};
+        return static_cast<uint8_t *>(ring_start) + offset;
+    };
 
-                samples[0] = triggersettings_private.get_initial_sample_value();
-                adc::set_clkdiv_u32(datac1_glob.adc_div);
+    auto set_frame_start = [&](uint32_t index) {
+        datac0_private.array1_start = get_ring_sample(index);
+        datac0_private.array1_offset = packed ? index % 2 : 0;
+    };
 
-                datac0_private.set_array1(adc_buffer_u16, datac1_glob.number_of_samples, 0);
-                datac0_private.trigger_index = 0;
+    // Window is closed after enough samples or time, or at the end of the capture
+    auto update_dc_level = [&](bool close_window) {
+        uint32_t sum, total;
+        dma_chunk_ring.get_sniffed(sum, total);
+        const uint32_t samples{total - dc_window_total};
+        if (samples == 0) return;
+        const uint32_t now_us{time_us_32()};
+        if (!close_window && samples < dc_window_max_samples && now_us - dc_window_start_us < dc_window_time_us) return;
 
-                // TODO: Ability to choose which channels in particular are on
-                // How many channels are enabled 0 - 4
-                adc_set_round_robin(adc::get_round_robin_mask(datac1_glob.number_of_channels));
+        const float full_scale{static_cast<float>((1U << sampling_size) - 1)};
+        datac0_private.dc_level = static_cast<float>(sum - dc_window_sum) / static_cast<float>(samples) / full_scale;
+        sniffed_dc_level = datac0_private.dc_level;
+        dc_window_sum = sum;
+        dc_window_total = total;
+        dc_window_start_us = now_us;
+    };
 
-                // TODO: Select trigger input as first
-                adc_select_input(0);  // ADC should always start with channel 0
+    auto settings_applied = [&](uint32_t settings_time_us) {
+        if (settings_time_us != applied_settings_us) {
+            applied_settings_us = settings_time_us;
+            settings_latency_us = time_us_32() - settings_time_us;
+        }
+    };
 
-                trigger_channel_index_div = adc::get_round_robin_index_divider(datac1_glob.number_of_channels);
+    auto stop_conversions = [&]() {
+        // Next period of the generator would start the ADC again
+        dma::set_channel_enabled(sync_chan, false);
+        timer_pacing.stop();
+        adc_run(false);
+    };
 
-                current_channel = trigger_channel_index_div - 1;
+    // Probe reads conversions straight from the FIFO, no capture is running meanwhile
+    auto run_autoset = [&]() {
+        datac1_glob.lock_blocking();
+        const uint probe_input{adc::get_valid_trigger_input(datac1_glob.channel_mask, datac1_glob.trigger_settings.get_trigger_channel())};
+        datac1_glob.unlock();
 
-                datac1_glob.unlock();
+        adc_set_round_robin(0);
+        adc_select_input(probe_input);
+        adc_fifo_setup(true, false, 1, false, false);
+        autoset::Measurement measurement;
+        for (const float probe_samplerate : autoset_probe_samplerates) {
+            const uint32_t probe_div{adc::div_from_samplerate(probe_samplerate)};
+            adc::set_clkdiv_u32(probe_div);
+            adc_fifo_drain();
+            adc_run(true);
+            for (size_t i{0}; i < hires_buffer_size; ++i) {
+                hires_buffer[i] = adc_fifo_get_blocking();
+            }
+            adc_run(false);
+            adc_fifo_drain();
+            measurement = autoset::measure(hires_buffer, hires_buffer_size, adc::samplerate_form_div(probe_div), trig::Settings::max_raw_u12);
+            if (measurement.period_s > 0.0f) break;
+        }
+        autoset_measurement = measurement;
+    };
 
-                dma_channel_configure(adc_chan, &adc_chan_cfg, adc_buffer_addr, &(adc_hw->fifo), adc_buffer_size_u16, false);
-                dma_channel_configure(ctrl_chan, &ctrl_chan_cfg, ctrl_chan_write_addr, ctrk_chan_read_addr, 1, false);
+    // Every enabled input is probed on its own at full rate, the histogram of the DNL step is kept in adc_buffer_u16
+    auto run_calibration = [&]() {
+        datac1_glob.lock_blocking();
+        const uint32_t channel_mask{datac1_glob.channel_mask & adc::all_channels_mask};
+        datac1_glob.unlock();
 
-                wait_for_next_cycle = false;
-                second_cycle_tx_count = 0;
-                trigger_detected = false;
-                ctrl_channel_trigered = false;
-                adc_chan_null_trigger = false;
-                adc_running = true;
-                adc_done = false;
-                if (c0msg == START_ADC_SINGLE) {
-                    ctrl_chan_adc_write = adc_buffer_addr;
-                    dma_cycle_forever = true;
+        const cal::Step step{calibration_step};
+        calibration_measurement.channel_mask = channel_mask;
+        adc_set_round_robin(0);
+        adc_fifo_setup(true, false, 1, false, false);
+        adc::set_clkdiv_u32(adc::div_from_samplerate(adc::max_samplerate));
+        for (uint input{0}; input < adc::max_channels; ++input) {
+            if (!(channel_mask & (1U << input))) continue;
+            adc_select_input(input);
+            adc_fifo_drain();
+            adc_run(true);
+            if (step == cal::Step::DNL) {
+                uint16_t *const histogram{adc_buffer_u16};
+                for (size_t code{0}; code < cal::codes; ++code) {
+                    histogram[code] = 0;
+                }
+                for (uint32_t i{0}; i < cal::histogram_samples; ++i) {
+                    uint16_t &count{histogram[adc_fifo_get_blocking() & 0x0FFFU]};
+                    if (count < UINT16_MAX) ++count;
+                }
+                cal::estimate_dnl(histogram, calibration_measurement.dnl[input]);
+            } else {
+                uint32_t sum{0};
+                for (uint32_t i{0}; i < cal::level_samples; ++i) {
+                    sum += adc_fifo_get_blocking();
+                }
+                const float level{static_cast<float>(sum) / cal::level_samples};
+                if (step == cal::Step::LOW) {
+                    calibration_measurement.low[input] = level;
                 } else {
-                    ctrl_chan_adc_write = 0;
-                    dma_cycle_forever = false;
+                    calibration_measurement.high[input] = level;
                 }
+            }
+            adc_run(false);
+            adc_fifo_drain();
+        }
+    };
 
+    auto stop_capture = [&]() {
+        dma_chunk_ring.stop();
+        stop_conversions();
+        gpio_set_irq_enabled(ext_trigger_pin, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, false);
+        gpio_put(trigger_out_pin, false);
+        dma_channel_abort(adc_chan);
+        adc_running = false;
+        capture_slot = CaptureSlots::none;
 #ifndef NDEBUG
-                debug_data.clear();
+        debug_data.adc_running = false;
 #endif
+    };
+
+    // Frame that was not taken by Core0 yet is dropped, so every slot can be overwritten
+    auto drop_published_frames = [&]() {
+        datac0_glob.lock_blocking();
+        datac0_glob.new_frame = false;
+        datac0_glob.unlock();
+        published_slot = CaptureSlots::none;
+        pending_slot = CaptureSlots::none;
+    };
+
+    // Published slot is free again once Core0 has sent it and released the data
+    auto release_published_slot = [&]() {
+        if (published_slot != CaptureSlots::none && datac0_glob.try_lock(nullptr)) {
+            if (!datac0_glob.new_frame) {
+                published_slot = CaptureSlots::none;
+            }
+            datac0_glob.unlock();
+        }
+    };
+
+    // Latest frame wins, a frame Core0 has not started sending yet is replaced by the newer one
+    auto publish_pending_frame = [&]() {
+        if (datac0_glob.try_lock(nullptr)) {
+            const bool notify_core0{!datac0_glob.new_frame};
+            datac0_glob = pending_frame;
+            datac0_glob.new_frame = true;
+            datac0_glob.unlock();
+            published_slot = pending_slot;
+            pending_slot = CaptureSlots::none;
+            if (notify_core0) {
+                send_msg_to_core0(core1_message::ADC_DONE);
+            }
+        }
+    };
+
+    // Starts DMA and ADC into the current segment, settings and ADC clock are already set
+    auto arm_segment = [&]() {
+        const size_t segment_offset{segment_index * segment_size};
+        ring_start = static_cast<uint8_t *>(slot_start) +
+                     (packed ? dsp::get_packed12_bytes(segment_offset) : segment_offset * get_bytes_per_sample(sampling_size));
+        // Every round robin cycle stays whole in the ring, so the lanes of a cycle are never read from the previous pass
+        ring_size = static_cast<uint32_t>(segment_size - segment_size % trigger_channel_index_div);
+
+        end_index = datac1_private.number_of_samples;
+
+        datac0_private.set_array1(ring_start, datac1_private.number_of_samples, 0);
+        datac0_private.array2_start = ring_start;
+        datac0_private.trigger_index = 0;
+
+        // Conversions left from the previous segment would shift the channel order
+        adc_fifo_drain();
+
+        // Trigger input is sampled first, so it is the lane 0 of every round robin cycle
+        adc_select_input(trigger_input);
+
+        // Scanning starts at the first trigger input sample after the pretrigger part
+        const float ring_samplerate{conversion_rate / hires_factor};
+        scanner.set_channels(datac1_private.channel_mask, trigger_input);
+        scanner.reset(triggersettings_private,
+                      ((pretrig_samples + trigger_channel_index_div - 1) / trigger_channel_index_div) * trigger_channel_index_div,
+                      trigger_channel_index_div, ring_samplerate / trigger_channel_index_div);
+
+        // Holdoff counts from the previous trigger, samples taken sooner are not searched
+        const uint64_t since_trigger_us{time_us_64() - last_trigger_us};
+        if (triggersettings_private.get_holdoff_us() > since_trigger_us) {
+            scanner.skip(static_cast<size_t>(static_cast<float>(triggersettings_private.get_holdoff_us() - since_trigger_us) * ring_samplerate / 1000000.0f));
+        }
+
+        // In 8-bit mode the ADC FIFO shifts results to a byte and DMA writes bytes
+        channel_config_set_transfer_data_size(&adc_chan_cfg, sampling_size == adc::sampling_size_t::U8 ? DMA_SIZE_8 : DMA_SIZE_16);
+        ring_cycling = !generator_sync && c0msg != START_ADC_AUTO;
+        if (is_staged()) {
+            hires_read_index = 0;
+            hires_write_index = 0;
+            decimator.reset(hires_factor, trigger_channel_index_div);
+            dma_chunk_ring.reset(adc_chan, hires_buffer, hires_buffer_size, etl::min<uint32_t>(hires_buffer_size / hires_chunks, dma_chunk_size),
+                                 sizeof(uint16_t), dma::ChunkRing::wrap_forever);
+        } else {
+            dma_chunk_ring.reset(adc_chan, ring_start, ring_size, dma_chunk_size, get_bytes_per_sample(sampling_size),
+                                 ring_cycling ? dma::ChunkRing::wrap_forever : 0);
+        }
+        dma_channel_configure(adc_chan, &adc_chan_cfg, is_staged() ? hires_buffer : ring_start, &(adc_hw->fifo),
+                              dma_chunk_ring.get_first_length(), false);
+        dma_channel_configure(ctrl_chan, &ctrl_chan_cfg, ctrl_chan_write_addr, dma_chunk_ring.get_next_write_addr_source(), 1, false);
+        current_written = 0;
+        current_cycles = 0;
+        current_total = 0;
+
+        wait_for_next_cycle = false;
+        second_cycle_tx_count = 0;
+        trigger_detected = false;
+        adc_running = true;
+        adc_done = false;
+        if (generator_sync) {
+            trigger_detected = true;
+            array_index = 0;
+        }
+        arm_external_trigger();
 
-                adc_fifo_setup(true, true, 1, false, false);
-                dma_channel_start(adc_chan);
-                adc_run(true);
-            } else if (c0msg == STOP_ADC) {
-                ctrl_chan_adc_write = 0;
-                adc_run(false);
-                dma_channel_abort(adc_chan);
-                adc_running = false;
-                trigger_detected = false;
 #ifndef NDEBUG
-                debug_data.adc_running = false;
+        debug_data.clear();
 #endif
-            }
+
+        adc_fifo_setup(true, true, 1, false, sampling_size == adc::sampling_size_t::U8);
+        dma::reset_sniffer_sum();
+        dc_window_sum = 0;
+        dc_window_total = 0;
+        dc_window_start_us = time_us_32();
+        dma_channel_start(adc_chan);
+        dma_chunk_ring.start();
+        if (timer_paced) {
+            timer_pacing.start(conversion_rate);
+        } else if (generator_sync) {
+            dma::set_channel_enabled(sync_chan, true);
+        } else {
+            adc_run(true);
         }
+        segment_start_us = time_us_32();
+        // Segment without trigger keeps its start time
+        trigger_time_us = time_us_64();
+    };
 
-        /*
-         * Handle running ADC
-         */
-        if (adc_running) {
-            /*
-             * Check for Trigger
-             */
-            const uint32_t tx_count = dma::get_transfer_count(adc_chan);
-            if (current_tx_count != tx_count) {
-                uint32_t diff{0};
-                if (current_tx_count < tx_count) {
-                    diff = adc_buffer_size_u16 - tx_count + current_tx_count;
+    auto start_capture = [&]() {
+        size_t slot{capture_slots.get_free(published_slot, pending_slot)};
+        if (slot == CaptureSlots::none) {
+            release_published_slot();
+            slot = capture_slots.get_free(published_slot, pending_slot);
+            if (slot == CaptureSlots::none) return;
+        }
+
+        datac1_glob.lock_blocking();
+        datac1_private = datac1_glob;
+        datac1_glob.unlock();
+        settings_applied(datac1_private.settings_time_us);
+
+        // Roll and stream modes read raw samples of the whole slot, modes that process acquisitions are left out
+        free_running = c0msg == START_ADC_ROLL || c0msg == START_ADC_STREAM;
+        recording = c0msg == START_ADC_RECORD;
+        datac0_private.freeze_latency_us = 0;
+        // Deep capture needs a cycling ring, AUTO mode and samplerates USB cannot follow capture into the buffer only
+        deep_samples = free_running || recording || c0msg == START_ADC_AUTO ||
+                               !is_deep_capture_possible(datac1_private.get_samplerate(), datac1_private.sampling_size)
+                           ? 0
+                           : datac1_private.deep_samples;
+        // Timer pacing starts every conversion on its own, so it cannot follow the generator
+        generator_sync = datac1_private.generator_sync && !free_running && !recording && datac1_private.timer_samplerate <= 0.0f;
+        if (generator_sync) {
+            deep_samples = 0;
+            datac1_private.ets_factor = 1;
+        }
+        // Edge of the external input is placed by the DMA counter, so DMA has to write the capture directly
+        external_trigger =
+            datac1_private.trigger_settings.get_source() == trig::Settings::Source::EXTERNAL && !free_running && !recording && !generator_sync;
+        if (external_trigger) {
+            datac1_private.hires = false;
+        }
+        if (free_running || recording || deep_samples > 0) {
+            datac1_private.ets_factor = 1;
+            datac1_private.average_count = 1;
+            datac1_private.hires = false;
+            datac1_private.number_of_segments = 1;
+        }
+
+        // Equivalent-time sampling works with 12-bit samples and takes the whole buffer, its phase is interpolated at an edge
+        // of the trigger channel
+        const bool edge_trigger{datac1_private.trigger_settings.get_type() == trig::Settings::Type::EDGE &&
+                                datac1_private.trigger_settings.get_combination() == trig::Settings::Combination::SINGLE && !external_trigger};
+        ets_factor = edge_trigger ? etl::max(datac1_private.ets_factor, uint32_t(1)) : 1;
+        if (ets_factor > 1) {
+            datac1_private.sampling_size = adc::sampling_size_t::U12;
+            datac1_private.number_of_segments = 1;
+        }
+
+        // Averaged acquisitions have to be aligned on the same grid, ETS already averages on its own
+        average_count = ets_factor > 1 ? 1 : etl::clamp(datac1_private.average_count, uint32_t(1), max_average_count);
+        if (average_count > 1) {
+            datac1_private.sampling_size = adc::sampling_size_t::U12;
+            datac1_private.number_of_segments = 1;
+        }
+
+        // Hi-res mode runs the ADC at full rate and averages down to the selected samplerate,
+        // timer-paced capture averages as many conversions per sample as the timer allows
+        timer_paced = datac1_private.timer_samplerate > 0.0f;
+        hires_factor = 1;
+        uint32_t capture_adc_div{datac1_private.adc_div};
+        conversion_rate = datac1_private.get_samplerate();
+        if (datac1_private.hires && ets_factor == 1) {
+            const uint32_t full_rate_div{adc::div_from_samplerate(adc::max_samplerate)};
+            const float max_rate{timer_paced ? adc::max_timer_conversion_rate : adc::samplerate_form_div(full_rate_div)};
+            hires_factor = etl::clamp(static_cast<uint32_t>(max_rate / conversion_rate + 0.5f), uint32_t(1), dsp::BoxcarDecimator::max_factor);
+            if (hires_factor > 1) {
+                datac1_private.sampling_size = adc::sampling_size_t::U12;
+                if (timer_paced) {
+                    conversion_rate *= hires_factor;
                 } else {
-                    diff = current_tx_count - tx_count;
+                    capture_adc_div = full_rate_div;
+                    conversion_rate = adc::samplerate_form_div(capture_adc_div);
                 }
-                current_tx_count = tx_count;
+            }
+        }
 
-                current_channel = (current_channel + diff) % trigger_channel_index_div;
+        // Packing keeps pace with the ADC only for plain captures read by Core1, its frames have a single segment
+        packed = datac1_private.packed && datac1_private.sampling_size == adc::sampling_size_t::U12 && hires_factor == 1 && !free_running &&
+                 !recording && deep_samples == 0 && !external_trigger && ets_factor == 1 && average_count == 1;
+        if (packed) {
+            datac1_private.number_of_segments = 1;
+        }
+        // Frame selected for the packed buffer is shortened when the capture is not packed
+        const size_t capacity{get_adc_buffer_capacity(datac1_private.sampling_size, packed)};
+        if (datac1_private.number_of_samples > capacity) {
+            const size_t number_of_channels{adc::get_round_robin_index_divider(datac1_private.channel_mask)};
+            datac1_private.number_of_samples = capacity - capacity % number_of_channels;
+        }
 
-                if (wait_for_next_cycle && current_tx_count > end_tx_count) {
-                    wait_for_next_cycle = false;
-                }
+        const size_t requested_segments{etl::clamp(datac1_private.number_of_segments, size_t(1), max_segments)};
+        const size_t layout_samples{free_running || recording || deep_samples > 0 || ets_factor > 1 || average_count > 1
+                                        ? adc_buffer_size_u16
+                                        : datac1_private.number_of_samples * requested_segments};
+        if (capture_slots.set_layout(layout_samples, datac1_private.sampling_size, packed)) {
+            drop_published_frames();
+            slot = 0;
+        }
+        capture_slot = slot;
+        slot_start = capture_slots.get_start(slot);
+        datac0_private.segments = frame_segments[slot];
+
+        // Every segment has to hold the whole frame, segments that do not fit are left out
+        const size_t slot_size{capture_slots.get_size()};
+        const size_t fitting_segments{datac1_private.number_of_samples > 0 ? slot_size / datac1_private.number_of_samples : 1};
+        number_of_segments = etl::clamp(fitting_segments, size_t(1), requested_segments);
+        segment_size = (slot_size / number_of_segments) & ~size_t(3);
+        segment_index = 0;
+        segment_dead_time_us = 0;
+
+        if (ets_factor > 1) {
+            // Slot holds the reconstructed frame, its accumulators and the ring for single acquisitions
+            ets_points = etl::min(datac1_private.number_of_samples, max_ets_points) & ~size_t(1);
+            ets_output = static_cast<uint16_t *>(slot_start);
+            uint32_t *const ets_sums{reinterpret_cast<uint32_t *>(ets_output + ets_points)};
+            uint16_t *const ets_counts{reinterpret_cast<uint16_t *>(ets_sums + ets_points)};
+            reconstructor.reset(ets_output, ets_sums, ets_counts, ets_points, ets_factor);
+            ets_attempts = 0;
+
+            slot_start = ets_counts + ets_points;
+            segment_size = (slot_size - 4 * ets_points) & ~size_t(3);
+            // One acquisition covers the frame in ADC samples of all enabled channels
+            datac1_private.number_of_samples = (ets_points / ets_factor + 2) * adc::get_round_robin_index_divider(datac1_private.channel_mask);
+        } else if (average_count > 1) {
+            // Slot holds the averaged frame, its sums and the ring, four samples of the slot for every frame sample
+            const size_t channel_pair{2 * adc::get_round_robin_index_divider(datac1_private.channel_mask)};
+            datac1_private.number_of_samples = etl::max(etl::min(datac1_private.number_of_samples, slot_size / 4) / channel_pair, size_t(1)) * channel_pair;
+            average_output = static_cast<uint16_t *>(slot_start);
+            average_sums = reinterpret_cast<uint32_t *>(average_output + datac1_private.number_of_samples);
+            slot_start = average_sums + datac1_private.number_of_samples;
+            segment_size = (slot_size - 3 * datac1_private.number_of_samples) & ~size_t(3);
+        }
+
+        adc_init();
+
+        sampling_size = datac1_private.sampling_size;
+        triggersettings_private = datac1_private.trigger_settings;
+        triggersettings_private.set_sampling_size(sampling_size);
+        const uint8_t useful_bits{hires_factor > 1 ? dsp::BoxcarDecimator::get_effective_bits(hires_factor) : static_cast<uint8_t>(sampling_size)};
+        if (hires_factor > 1) {
+            // Trigger compares decimated samples
+            triggersettings_private.set_resolution_bits(useful_bits);
+        }
+        if (average_count > 1) {
+            averager.reset(average_output, average_sums, datac1_private.number_of_samples, average_count, useful_bits);
+        }
+
+        pretrig_samples = triggersettings_private.calculate_pretrig_count(datac1_private.number_of_samples);
+        if (generator_sync) {
+            pretrig_samples = 0;
+        }
+        posttrig_samples = datac1_private.number_of_samples - pretrig_samples;
+        if (deep_samples > 0) {
+            // Pretrigger has to stay in the ring until Core0 reads it
+            const size_t number_of_channels{adc::get_round_robin_index_divider(datac1_private.channel_mask)};
+            deep_samples = static_cast<uint32_t>((deep_samples / number_of_channels) * number_of_channels);
+            pretrig_samples = etl::min<uint32_t>(triggersettings_private.calculate_pretrig_count(deep_samples), segment_size / 2);
+            posttrig_samples = deep_samples - pretrig_samples;
+        }
+
+        adc::set_clkdiv_u32(capture_adc_div);
+
+        // Chunk spans about the same time at every samplerate, trigger is found at most one chunk after it was sampled
+        const float chunk_samples{conversion_rate * (dma_chunk_time_us / 1000000.0f)};
+        dma_chunk_size = etl::clamp(static_cast<uint32_t>(chunk_samples), dma_chunk_min_samples, dma_chunk_max_samples);
+
+        datac0_private.adc_div = capture_adc_div;
+        datac0_private.samplerate = conversion_rate;
+        datac0_private.decimation_factor = hires_factor;
+        datac0_private.useful_bits = average_count > 1 ? averager.get_output_bits() : useful_bits;
+        datac0_private.number_of_channels = adc::get_round_robin_index_divider(datac1_private.channel_mask);
+        datac0_private.sampling_size = sampling_size;
+        datac0_private.number_of_segments = number_of_segments;
+        datac0_private.ets_factor = ets_factor;
+        datac0_private.free_running = free_running;
+        datac0_private.deep_samples = deep_samples;
+        datac0_private.packed = packed;
+
+        adc_set_round_robin(adc::get_round_robin_mask(datac1_private.channel_mask));
+
+        trigger_channel_index_div = adc::get_round_robin_index_divider(datac1_private.channel_mask);
+        trigger_input = adc::get_valid_trigger_input(datac1_private.channel_mask, triggersettings_private.get_trigger_channel());
+        datac0_private.channel_mask = datac1_private.channel_mask;
+        datac0_private.trigger_channel = trigger_input;
+
+        arm_segment();
+        capture_start_us = segment_start_us;
+        idle_time_us = 0;
+
+        if (free_running) {
+            // Core0 gets the ring right away, the capture itself runs until STOP_ADC
+            datac0_private.set_array1(ring_start, ring_size, 0);
+            pending_slot = capture_slot;
+            pending_frame = datac0_private;
+        }
+    };
+
+    auto finish_capture = [&]() {
+        update_dc_level(true);
+        dma_chunk_ring.stop();
+        stop_conversions();
+        gpio_set_irq_enabled(ext_trigger_pin, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, false);
+        gpio_put(trigger_out_pin, false);
+        dma_channel_abort(adc_chan);
+        adc_running = false;
+        capture_end_us = time_us_32();
+#ifndef NDEBUG
+        debug_data.adc_running = false;
+#endif
+        const uint32_t sum_samples = pretrig_samples + posttrig_samples;
+        datac0_private.first_channel = (trigger_channel_index_div - pretrig_samples % trigger_channel_index_div) % trigger_channel_index_div;
+        if (trigger_detected && array_index >= pretrig_samples) {
+            if (second_cycle_tx_count) {
+                const uint32_t start_index = array_index - pretrig_samples;
+                const uint32_t first_cycle_samples = ring_size - start_index;
+                set_frame_start(array_index - pretrig_samples);
+                datac0_private.trigger_index = pretrig_samples;
+                datac0_private.array1_samples = first_cycle_samples;
+                datac0_private.array2_samples = sum_samples - first_cycle_samples;
+            } else {
+                set_frame_start(array_index - pretrig_samples);
+                datac0_private.array1_samples = sum_samples;
+                datac0_private.trigger_index = pretrig_samples;
+            }
+        } else if (trigger_detected && array_index < pretrig_samples) {
+            const uint32_t missing_samples = pretrig_samples - array_index;
+            set_frame_start(ring_size - missing_samples);
+            datac0_private.trigger_index = pretrig_samples;
+            datac0_private.array1_samples = missing_samples;
+            datac0_private.array2_samples = sum_samples - missing_samples;
+        }
+#ifndef NDEBUG
+        debug_data.array_index = array_index;
+#endif
+
+        if (ets_factor > 1) {
+            if (trigger_detected) {
+                // Sub-sample phase of the trigger is interpolated from the trigger sample and the one before it
+                const uint16_t *const ring{static_cast<const uint16_t *>(ring_start)};
+                const uint16_t before{ring[(array_index + ring_size - trigger_channel_index_div) % ring_size]};
+                const uint32_t phase{ets::Reconstructor::get_crossing_phase(before, ring[array_index], triggersettings_private.get_scan_threshold())};
+                const size_t first_index{(trigger_channel_index_div - datac0_private.first_channel) % trigger_channel_index_div};
+                reconstructor.add(static_cast<const uint16_t *>(datac0_private.array1_start), datac0_private.array1_samples,
+                                  static_cast<const uint16_t *>(datac0_private.array2_start), datac0_private.array2_samples, first_index,
+                                  trigger_channel_index_div, (datac0_private.trigger_index - first_index) / trigger_channel_index_div, phase);
+            }
+            if (!reconstructor.is_complete() && ++ets_attempts < ets_factor * max_ets_attempts_per_phase) {
+                arm_segment();
+                return;
+            }
+
+            // Only the trigger channel is reconstructed
+            reconstructor.reconstruct();
+            datac0_private.set_array1(ets_output, ets_points, 0);
+            datac0_private.array2_start = ets_output;
+            datac0_private.trigger_index = reconstructor.get_zero_index();
+            datac0_private.first_channel = 0;
+            datac0_private.number_of_channels = 1;
+            datac0_private.channel_mask = 1U << trigger_input;
+        } else if (average_count > 1 && trigger_detected) {
+            averager.add(static_cast<const uint16_t *>(datac0_private.array1_start), datac0_private.array1_samples,
+                         static_cast<const uint16_t *>(datac0_private.array2_start), datac0_private.array2_samples);
+            if (!averager.is_complete()) {
+                arm_segment();
+                return;
+            }
+
+            // Every acquisition starts on the same channel, trigger index and first channel stay valid
+            averager.average();
+            datac0_private.set_array1(average_output, pretrig_samples + posttrig_samples, 0);
+            datac0_private.array2_start = average_output;
+        }
+
+        frame_segments[capture_slot][segment_index] = {datac0_private.array1_start,   datac0_private.array2_start,  datac0_private.array1_samples,
+                                                       datac0_private.array2_samples, datac0_private.trigger_index, segment_dead_time_us,
+                                                       trigger_time_us};
+        if (++segment_index < number_of_segments) {
+            // Next event is captured without waiting for Core0
+            arm_segment();
+            segment_dead_time_us = segment_start_us - capture_end_us;
+            return;
+        }
+        datac0_private.capture_time_us = capture_end_us - capture_start_us;
+        datac0_private.idle_time_us = idle_time_us;
+
+        // Slot of an older frame that is still waiting for Core0 is reused
+        pending_slot = capture_slot;
+        pending_frame = datac0_private;
+        capture_slot = CaptureSlots::none;
+        if (c0msg == START_ADC_SINGLE) {
+            acquisition_active = false;
+        }
+    };
 
-                if (!dma_cycle_forever && !wait_for_next_cycle && current_tx_count <= end_tx_count) {
-                    adc_run(false);
-                    adc_done = true;
+    // Ring stops right after the event, the frame is the last samples written before the round robin cycle of the event
+    auto freeze_recording = [&](uint32_t event_total, uint32_t event_us) {
+        stop_conversions();
+        dma_chunk_ring.stop();
+        const uint32_t freeze_total{dma_chunk_ring.get_current_total()};
+        dma_channel_abort(adc_chan);
+        gpio_set_irq_enabled(ext_trigger_pin, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, false);
+        gpio_put(trigger_out_pin, false);
+        const uint32_t freeze_us{time_us_32()};
+        adc_running = false;
+        capture_end_us = freeze_us;
 #ifndef NDEBUG
-                    debug_data.adc_done = true;
+        debug_data.adc_running = false;
 #endif
-                } else if (!trigger_detected && (current_tx_count < pretring_tx_count || ctrl_channel_trigered) && current_tx_count < adc_buffer_size_u16) {
-                    array_index = adc_buffer_size_u16 - current_tx_count - 1;
-                    // Check for trigger only in channel 0 samples
-                    if (current_channel == 0) {
-                        samples[1] = adc_buffer_u16[array_index];
-                        if (triggersettings_private.detect_edge_raw(samples[0], samples[1])) {
-                            if (current_tx_count < posttrig_samples) {
-                                second_cycle_tx_count = (posttrig_samples - current_tx_count);
-                                end_tx_count = adc_buffer_size_u16 - second_cycle_tx_count;
+        update_dc_level(true);
+
+        // Samples left in the ADC FIFO may still overwrite the oldest ones
+        constexpr uint32_t fifo_margin{4};
+        const uint32_t channels{static_cast<uint32_t>(trigger_channel_index_div)};
+        const uint32_t end_total{event_total - event_total % channels};
+        const uint32_t overwritten{freeze_total - end_total + fifo_margin};
+        const uint32_t available{overwritten < ring_size ? ring_size - overwritten : 0};
+        uint32_t frame_samples{etl::min(static_cast<uint32_t>(datac1_private.number_of_samples), etl::min(available, end_total))};
+        frame_samples -= frame_samples % channels;
+
+        const uint32_t start_index{(end_total - frame_samples) % ring_size};
+        const uint32_t first_cycle_samples{etl::min(frame_samples, ring_size - start_index)};
+        datac0_private.set_array1(ring_start, first_cycle_samples, frame_samples - first_cycle_samples);
+        set_frame_start(start_index);
+        datac0_private.array2_start = ring_start;
+        datac0_private.trigger_index = frame_samples >= channels ? frame_samples - channels : 0;
+        datac0_private.first_channel = 0;
+        datac0_private.freeze_latency_us = freeze_us - event_us;
+        frame_segments[capture_slot][0] = {datac0_private.array1_start,   datac0_private.array2_start,  datac0_private.array1_samples,
+                                           datac0_private.array2_samples, datac0_private.trigger_index, 0,
+                                           time_us_64() - datac0_private.freeze_latency_us};
+        datac0_private.capture_time_us = capture_end_us - capture_start_us;
+        datac0_private.idle_time_us = idle_time_us;
+
+        pending_slot = capture_slot;
+        pending_frame = datac0_private;
+        capture_slot = CaptureSlots::none;
+        acquisition_active = false;
+    };
+
+    // Scans every sample written since the last call, the block may wrap around the end of the ring
+    auto handle_written_samples = [&](uint32_t write_index, bool buffer_restarted) {
+        if (buffer_restarted) {
+            if (!trigger_detected) {
+                scan_for_trigger(ring_size, current_total - current_written - ring_size);
+            }
+            scanner.wrap(ring_size);
+            if (wait_for_next_cycle) {
+                wait_for_next_cycle = false;
+            } else if (trigger_detected) {
+                // Trigger found in the tail of the previous cycle, its samples are already complete
+                end_index = 0;
+            }
+        }
+
+        // Without cycling the trigger is searched only inside the requested number of samples
+        if (!trigger_detected) {
+            scan_for_trigger(ring_cycling ? write_index : etl::min(write_index, end_index), current_total - current_written);
+        }
+
+        if (!ring_cycling && !wait_for_next_cycle && write_index >= end_index) {
+            stop_conversions();
+            adc_done = true;
 #ifndef NDEBUG
-                                debug_data.second_cycle = second_cycle_tx_count;
+            debug_data.adc_done = true;
 #endif
-                                wait_for_next_cycle = true;
-                                dma_cycle_forever = false;
-                                ctrl_chan_adc_write = adc_buffer_addr;
-                                // dma_channel_set_trans_count(adc_chan, second_cycle_tx_count, true);
-                            } else {
-                                end_tx_count = current_tx_count - posttrig_samples;
-                                ctrl_chan_adc_write = 0;
-                            }
-                            dma_cycle_forever = false;
-                            trigger_detected = true;
+        }
+    };
 
+    // Decimates or packs hi-res buffer samples up to read_end into the ring, writing stops at the end of the frame
+    auto process_hires_samples = [&](size_t read_end) {
+        while (hires_read_index < read_end && !adc_done) {
+            const bool stop_at_end{!ring_cycling && !wait_for_next_cycle};
+            const size_t write_end{stop_at_end ? etl::min<size_t>(end_index, ring_size) : ring_size};
+            if (hires_write_index >= write_end) {
+                handle_written_samples(hires_write_index, false);
+                break;
+            }
 #ifndef NDEBUG
-                            debug_data.trigger_detected = true;
+            const size_t decimation_start_index = hires_read_index;
+            const uint32_t decimation_start_us = time_us_32();
 #endif
-                        }
+            size_t written{0};
+            if (packed) {
+                written = etl::min(read_end - hires_read_index, write_end - hires_write_index);
+                dsp::pack12(ring_start, hires_write_index, &hires_buffer[hires_read_index], written);
+                hires_read_index += written;
+            } else {
+                hires_read_index += decimator.process(&hires_buffer[hires_read_index], read_end - hires_read_index,
+                                                      &static_cast<uint16_t *>(ring_start)[hires_write_index], write_end - hires_write_index, written);
+            }
+            hires_write_index += written;
+#ifndef NDEBUG
+            debug_data.add_decimation_time(hires_read_index - decimation_start_index, time_us_32() - decimation_start_us);
+#endif
+            if (hires_write_index == ring_size && !stop_at_end) {
+                hires_write_index = 0;
+                handle_written_samples(0, true);
+            } else {
+                handle_written_samples(hires_write_index, false);
+            }
+        }
+    };
 
-                        samples[0] = samples[1];
+    // Capture that is still searching for its trigger takes new trigger settings and samplerate in place, without adc_init()
+    // and DMA setup, captures combining several acquisitions or with a trigger already found take them at the next start
+    auto apply_live_settings = [&]() {
+        datac1_glob.lock_blocking();
+        trig::Settings live_trigger{datac1_glob.trigger_settings};
+        const uint32_t live_adc_div{datac1_glob.adc_div};
+        const bool live_timer_paced{datac1_glob.timer_samplerate > 0.0f};
+        const uint32_t settings_time_us{datac1_glob.settings_time_us};
+        datac1_glob.unlock();
+
+        if (!adc_running || trigger_detected || free_running || recording || generator_sync || deep_samples > 0 || ets_factor > 1 || average_count > 1 ||
+            number_of_segments > 1) {
+            return;
+        }
+
+        live_trigger.set_trigger_channel(trigger_input);
+        live_trigger.set_sampling_size(sampling_size);
+        if (hires_factor > 1) {
+            live_trigger.set_resolution_bits(dsp::BoxcarDecimator::get_effective_bits(hires_factor));
+        }
+        triggersettings_private = live_trigger;
+
+        // Whole new pretrigger has to be sampled after the trigger search continues
+        size_t skipped_samples{0};
+        const uint32_t live_pretrig_samples{static_cast<uint32_t>(triggersettings_private.calculate_pretrig_count(datac1_private.number_of_samples))};
+        if (live_pretrig_samples != pretrig_samples) {
+            skipped_samples = live_pretrig_samples;
+            pretrig_samples = live_pretrig_samples;
+            posttrig_samples = datac1_private.number_of_samples - pretrig_samples;
+        }
+
+        // Only the divider of a ring that cycles until the trigger changes, the frame starts after the samples of the old rate
+        if (live_adc_div != datac0_private.adc_div && !live_timer_paced && !timer_paced && !is_staged() && ring_cycling) {
+            adc::set_clkdiv_u32(live_adc_div);
+            conversion_rate = adc::samplerate_form_div(live_adc_div);
+            datac0_private.adc_div = live_adc_div;
+            datac0_private.samplerate = conversion_rate;
+            const size_t unscanned{current_written > scanner.get_next_index() ? current_written - scanner.get_next_index() : 0};
+            skipped_samples = unscanned + dma_chunk_size + pretrig_samples;
+        }
+
+        // Trigger times are converted at the rate the next samples are taken with
+        scanner.update(triggersettings_private, conversion_rate / hires_factor / trigger_channel_index_div);
+        // Hi-res and packed captures keep the trigger channel until the next start, they are not written by DMA
+        external_trigger = triggersettings_private.get_source() == trig::Settings::Source::EXTERNAL && !is_staged();
+        arm_external_trigger();
+        scanner.skip(skipped_samples);
+        settings_applied(settings_time_us);
+    };
+
+    send_msg_to_core0(CORE1_STARTED);
+
+    while (true) {
+        /*
+         * Handle messages from Core0
+         */
+        if (fifo_contains_value()) {
+            const core0_message msg{get_msg_from_core0()};
+            if (msg == UPDATE_SETTINGS) {
+                // Mode of the running capture stays in c0msg
+                apply_live_settings();
+            } else if (msg == START_ADC_AUTO || msg == START_ADC_NORMAL || msg == START_ADC_SINGLE || msg == START_ADC_ROLL || msg == START_ADC_STREAM ||
+                       msg == START_ADC_RECORD) {
+                c0msg = msg;
+                if (adc_running) {
+                    stop_capture();
+                }
+                drop_published_frames();
+                acquisition_active = true;
+                previous_capture_valid = false;
+            } else if (msg == FREEZE) {
+                // Stop event is placed at the sample DMA writes now, Core0 sent it at freeze_request_us
+                if (adc_running && recording) {
+                    freeze_recording(dma_chunk_ring.get_current_total(), freeze_request_us);
+                }
+            } else if (msg == STOP_ADC) {
+                c0msg = msg;
+                stop_capture();
+                acquisition_active = false;
+                trigger_detected = false;
+            } else if (msg == AUTOSET) {
+                c0msg = STOP_ADC;
+                if (adc_running) {
+                    stop_capture();
+                }
+                acquisition_active = false;
+                trigger_detected = false;
+                run_autoset();
+                send_msg_to_core0(AUTOSET_DONE);
+            } else if (msg == CALIBRATE || msg == FLASH_WRITE) {
+                c0msg = STOP_ADC;
+                if (adc_running) {
+                    stop_capture();
+                }
+                acquisition_active = false;
+                trigger_detected = false;
+                // Histogram overwrites the slots
+                drop_published_frames();
+                if (msg == CALIBRATE) {
+                    run_calibration();
+                    send_msg_to_core0(CALIBRATE_DONE);
+                } else {
+                    // Lockout request of Core0 follows FLASH_WRITE, its handler keeps Core1 in RAM until the write is done
+                    irq_set_enabled(SIO_IRQ_PROC1, true);
+                    while (flash_write_pending) {
                     }
+                    irq_set_enabled(SIO_IRQ_PROC1, false);
                 }
             }
+        }
+
+        if (pending_slot != CaptureSlots::none) {
+            publish_pending_frame();
+        }
 
+        if (acquisition_active && !adc_running) {
+            start_capture();
+            if (adc_running) {
+                datac0_private.blind_time_us = previous_capture_valid ? capture_start_us - capture_end_us : 0;
+                previous_capture_valid = true;
+            }
+        }
+
+        /*
+         * Handle running ADC
+         */
+        bool core1_idle{true};
+        if (adc_running) {
+            update_dc_level(false);
+        }
+        if (adc_running && recording && ext_trigger_pending) {
+            ext_trigger_pending = false;
+            freeze_recording(ext_trigger_total, ext_trigger_us);
+            core1_idle = false;
+        }
+        if (adc_running && !free_running && !recording) {
             /*
-             * Check if DMA is finished
+             * Check for Trigger in complete DMA chunks
              */
-            if ((!dma_channel_is_busy(adc_chan) && dma_channel_hw_addr(adc_chan)->write_addr == 0) || adc_done) {
-                ctrl_chan_adc_write = 0;
-                adc_run(false);
-                dma_channel_abort(adc_chan);
-                adc_running = false;
-#ifndef NDEBUG
-                debug_data.adc_running = false;
-#endif
-                const uint32_t sum_samples = pretrig_samples + posttrig_samples;
-                datac0_private.first_channel = (uint32_t(0) - pretrig_samples) % trigger_channel_index_div;
-                if (trigger_detected && array_index >= pretrig_samples) {
-                    if (second_cycle_tx_count) {
-                        const uint32_t start_index = array_index - pretrig_samples;
-                        const uint32_t first_cycle_samples = adc_buffer_size_u16 - start_index;
-                        datac0_private.array1_start = &adc_buffer_u16[array_index - pretrig_samples];
-                        datac0_private.trigger_index = pretrig_samples;
-                        datac0_private.array1_samples = first_cycle_samples;
-                        datac0_private.array2_samples = sum_samples - first_cycle_samples;
-                    } else {
-                        datac0_private.array1_start = &adc_buffer_u16[array_index - pretrig_samples];
-                        datac0_private.array1_samples = sum_samples;
-                        datac0_private.trigger_index = pretrig_samples;
+            uint32_t written, cycles;
+            dma_chunk_ring.get_progress(written, cycles, current_total);
+            if (current_written != written || current_cycles != cycles) {
+                const bool buffer_restarted{current_cycles != cycles};
+                current_written = written;
+                current_cycles = cycles;
+                if (is_staged()) {
+                    if (buffer_restarted) {
+                        process_hires_samples(hires_buffer_size);
+                        hires_read_index = 0;
                     }
-                } else if (trigger_detected && array_index < pretrig_samples) {
-                    const uint32_t missing_samples = pretrig_samples - array_index;
-                    datac0_private.array1_start = &adc_buffer_u16[adc_buffer_size_u16 - missing_samples];
-                    datac0_private.trigger_index = pretrig_samples;
-                    datac0_private.array1_samples = missing_samples;
-                    datac0_private.array2_samples = sum_samples - missing_samples;
+                    process_hires_samples(current_written);
+                } else {
+                    handle_written_samples(current_written, buffer_restarted);
                 }
-#ifndef NDEBUG
-                debug_data.array_index = array_index;
-#endif
+            }
 
-                datac0_glob.lock_blocking();
-                datac0_glob = datac0_private;
-                datac0_glob.unlock();
-                send_msg_to_core0(core1_message::ADC_DONE);
+            /*
+             * Deep frame is already with Core0, the capture ends once DMA has written all its samples
+             */
+            if (deep_samples > 0 && trigger_detected) {
+                if (static_cast<int32_t>(current_total - deep_end_total) >= 0) {
+                    stop_capture();
+                    capture_end_us = time_us_32();
+                    if (c0msg == START_ADC_SINGLE) {
+                        acquisition_active = false;
+                    }
+                    core1_idle = false;
+                }
+            } else if ((!dma_channel_is_busy(adc_chan) && dma_channel_hw_addr(adc_chan)->write_addr == 0) || adc_done) {
+                finish_capture();
+                core1_idle = false;
             }
         }
+
+        /*
+         * Sleep until the next DMA chunk, a message from Core0 or a released mutex, all of them send an event
+         */
+        if (core1_idle && !fifo_contains_value()) {
+            const uint32_t idle_start_us = time_us_32();
+            __wfe();
+            idle_time_us += time_us_32() - idle_start_us;
+        }
     }
-}
\ No newline at end of file
+}
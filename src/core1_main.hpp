@@ -3,14 +3,107 @@
 #include <stddef.h>
 #include "pico/multicore.h"
 #include "pico/mutex.h"
+#include <etl/algorithm.h>
 
 #include "posc_trigger.hpp"
+#include "posc_autoset.hpp"
+#include "posc_packed.hpp"
+#include "posc_calibration.hpp"
 
 inline constexpr size_t adc_buffer_size_u16{110000};
+inline constexpr size_t adc_buffer_size_u8{adc_buffer_size_u16 * sizeof(uint16_t)};
+// Packed 12-bit samples take three bytes per two samples, the size stays multiple of 4 like the slots
+inline constexpr size_t adc_buffer_size_packed{(adc_buffer_size_u8 * 2 / 3) & ~size_t(3)};
 extern uint16_t adc_buffer_u16[adc_buffer_size_u16];
 
+// 8-bit samples are stored as bytes in the same memory, so the buffer holds twice as many
+inline constexpr size_t get_adc_buffer_capacity(adc::sampling_size_t sampling_size, bool packed = false) {
+    if (sampling_size == adc::sampling_size_t::U8) return adc_buffer_size_u8;
+    return packed ? adc_buffer_size_packed : adc_buffer_size_u16;
+}
+
+inline constexpr size_t get_bytes_per_sample(adc::sampling_size_t sampling_size) {
+    return sampling_size == adc::sampling_size_t::U8 ? sizeof(uint8_t) : sizeof(uint16_t);
+}
+
 void core1_main();
 
+// In segmented mode a capture slot holds this many back-to-back trigger events
+inline constexpr size_t max_segments{32};
+
+// Equivalent-time frame with its accumulators takes 4 samples of adc_buffer_u16 per point
+inline constexpr size_t max_ets_points{16384};
+// Acquisitions per ETS factor before an incomplete frame is sent anyway
+inline constexpr size_t max_ets_attempts_per_phase{32};
+// Sums of 15-bit samples stay within 32 bits even after the output shift
+inline constexpr uint32_t max_average_count{256};
+
+// DMA raises an interrupt after every chunk, 2048 samples are 4 KB of 16-bit samples
+inline constexpr uint32_t dma_chunk_max_samples{2048};
+inline constexpr uint32_t dma_chunk_min_samples{1};
+inline constexpr uint32_t dma_chunk_time_us{1000};
+
+// DC level is the mean of the DMA sniffer sum over a window, 2^19 samples of 12 bits keep the sum within 32 bits
+inline constexpr uint32_t dc_window_max_samples{1U << 19};
+inline constexpr uint32_t dc_window_time_us{100000};
+
+// Deep capture streams during acquisition, so its data rate has to stay below what USB sustains
+inline constexpr float deep_max_bytes_per_second{500000.0f};
+
+inline bool is_deep_capture_possible(float samplerate, adc::sampling_size_t sampling_size) {
+    return samplerate * get_bytes_per_sample(sampling_size) <= deep_max_bytes_per_second;
+}
+
+// adc_buffer_u16 is split into slots, so a new capture can run while Core0 sends the previous one
+class CaptureSlots {
+   public:
+    static constexpr size_t max_slots{3};
+    static constexpr size_t none{max_slots};
+
+    // Returns true when the slots were moved and old frames are no longer valid
+    bool set_layout(size_t number_of_samples, adc::sampling_size_t sampling_size, bool packed = false) {
+        const size_t capacity{get_adc_buffer_capacity(sampling_size, packed)};
+        size_t number_of_slots{number_of_samples > 0 ? capacity / number_of_samples : 1};
+        number_of_slots = etl::clamp(number_of_slots, size_t(1), max_slots);
+        // Slot size stays multiple of 4 so round robin channel order is the same in every slot
+        const size_t slot_size{(capacity / number_of_slots) & ~size_t(3)};
+        const size_t slot_bytes{packed ? dsp::get_packed12_bytes(slot_size) : slot_size * get_bytes_per_sample(sampling_size)};
+        if (number_of_slots == _number_of_slots && slot_size == _slot_size && slot_bytes == _slot_bytes) {
+            return false;
+        }
+        _number_of_slots = number_of_slots;
+        _slot_size = slot_size;
+        _slot_bytes = slot_bytes;
+        return true;
+    }
+
+    size_t get_free(size_t used_slot1, size_t used_slot2) const {
+        for (size_t slot{0}; slot < _number_of_slots; ++slot) {
+            if (slot != used_slot1 && slot != used_slot2) {
+                return slot;
+            }
+        }
+        return none;
+    }
+
+    void *get_start(size_t slot) const {
+        return reinterpret_cast<uint8_t *>(adc_buffer_u16) + slot * _slot_bytes;
+    }
+
+    size_t get_size() const {
+        return _slot_size;
+    }
+
+    size_t get_number_of_slots() const {
+        return _number_of_slots;
+    }
+
+   private:
+    size_t _number_of_slots{0};
+    size_t _slot_size{0};
+    size_t _slot_bytes{0};
+};
+
 struct debug_data_t {
     bool adc_running;
     bool trigger_detected;
@@ -19,12 +112,30 @@ struct debug_data_t {
     int dma_ctrl_chan;
     uint32_t second_cycle;
     uint32_t array_index;
+    uint32_t scanned_samples;
+    uint32_t scan_time_us;
+    uint32_t decimated_samples;
+    uint32_t decimation_time_us;
+
+    void add_scan_time(uint32_t samples, uint32_t time_us) {
+        scanned_samples += samples;
+        scan_time_us += time_us;
+    }
+
+    void add_decimation_time(uint32_t samples, uint32_t time_us) {
+        decimated_samples += samples;
+        decimation_time_us += time_us;
+    }
 
     void clear() {
         adc_running = true;
         trigger_detected = false;
         adc_done = false;
         second_cycle = 0;
+        scanned_samples = 0;
+        scan_time_us = 0;
+        decimated_samples = 0;
+        decimation_time_us = 0;
     }
 };
 
@@ -60,13 +171,27 @@ class MulticoreData {
     mutex_t *const _mutex;
 };
 
+// One trigger event of a segmented capture
+struct FrameSegment {
+    void *array1_start;
+    void *array2_start;
+    size_t array1_samples;
+    size_t array2_samples;
+    size_t trigger_index;
+    // Time between the end of the previous segment and the start of this one
+    uint32_t dead_time_us;
+    // Time the trigger was found, includes the polling delay of Core1
+    uint64_t trigger_time_us;
+};
+
 class DataForCore0 : public MulticoreData {
    public:
     DataForCore0(mutex_t *mutex = nullptr) : MulticoreData(mutex) {
     }
 
-    void set_array1(uint16_t *array1, size_t length1, size_t length2) {
+    void set_array1(void *array1, size_t length1, size_t length2) {
         array1_start = array1;
+        array1_offset = 0;
         array1_samples = length1;
         array2_samples = length2;
     }
@@ -75,7 +200,48 @@ class DataForCore0 : public MulticoreData {
     size_t array2_samples;
     size_t trigger_index;
     uint32_t first_channel;
-    uint16_t *array1_start;
+    void *array1_start;
+    void *array2_start;
+    bool new_frame{false};
+    // Packed frame starts at the pair of bytes array1_start points to, at its second sample when array1_offset is 1
+    bool packed{false};
+    size_t array1_offset{0};
+
+    // Settings the frame was captured with, Core1 may already capture with newer ones
+    uint32_t adc_div;
+    // Conversions per second of all channels, timer-paced frames have no ADC divider for it
+    float samplerate;
+    uint number_of_channels;
+    // Enabled inputs and the input of the first lane, first_channel is lane of the first sample
+    uint32_t channel_mask;
+    uint trigger_channel;
+    adc::sampling_size_t sampling_size;
+
+    uint32_t capture_time_us;
+    uint32_t blind_time_us;
+    // Time Core1 slept waiting for DMA chunks during the capture
+    uint32_t idle_time_us;
+
+    // Frames with more than one segment are sent from the segments table, it belongs to the capture slot of the frame
+    size_t number_of_segments{1};
+    const FrameSegment *segments{nullptr};
+
+    // Equivalent-time frames have factor times shorter sample period than the ADC
+    uint32_t ets_factor{1};
+    // Hi-res frames have factor times longer sample period than the ADC
+    uint32_t decimation_factor{1};
+    uint8_t useful_bits;
+    // Free-running frame describes the ring DMA keeps filling, Core0 reads new samples from it until STOP_ADC
+    bool free_running{false};
+    // Deep frame is published at the trigger, Core0 reads deep_samples from the ring starting at deep_start_index
+    // while DMA keeps writing, deep_start_total is the sample counter of DMA at that sample
+    uint32_t deep_samples{0};
+    uint32_t deep_start_index;
+    uint32_t deep_start_total;
+    // Mean of the last DC window of the capture as a fraction of the ADC range, all enabled channels together
+    float dc_level{0.0f};
+    // Time from the stop event of the flight recorder until the ring was frozen, 0 for other frames
+    uint32_t freeze_latency_us{0};
 };
 
 class DataForCore1 : public MulticoreData {
@@ -90,21 +256,71 @@ class DataForCore1 : public MulticoreData {
     size_t posttrigger_samples;
     size_t number_of_samples;
     uint32_t adc_div;
-    uint number_of_channels;
+    // Samplerate below the range of the ADC divider paced by a timer, 0 uses adc_div
+    float timer_samplerate{0.0f};
+    uint number_of_channels{1};
+    uint32_t channel_mask{0x1U};
+    sampling_size_t sampling_size{sampling_size_t::U12};
+    size_t number_of_segments{1};
+    uint32_t ets_factor{1};
+    bool hires{false};
+    // 12-bit samples are stored two in three bytes, so the buffer holds a third more of them
+    bool packed{false};
+    uint32_t average_count{1};
+    // Samples of a deep capture, 0 captures into the buffer only
+    uint32_t deep_samples{0};
+    // Capture starts at the start of a period of the function generator instead of a trigger
+    bool generator_sync{false};
     TriggerSettings trigger_settings;
+    // Time Core0 published live settings, Core1 measures the latency until they are used
+    uint32_t settings_time_us{0};
+
+    float get_samplerate() const {
+        return timer_samplerate > 0.0f ? timer_samplerate : adc::samplerate_form_div(adc_div);
+    }
 };
 
 enum core0_message : uint32_t {
     START_ADC_AUTO = 0x00000000U,
     STOP_ADC,
     START_ADC_SINGLE,
+    START_ADC_NORMAL,
+    START_ADC_ROLL,
+    START_ADC_STREAM,
+    // Trigger, pretrigger and samplerate in datac1_glob changed, the running capture takes them if it can
+    UPDATE_SETTINGS,
+    // Capture stops and the trigger channel is measured by probe captures, the result is in autoset_measurement
+    AUTOSET,
+    // Capture stops and the enabled inputs are measured for calibration_step, the result is in calibration_measurement
+    CALIBRATE,
+    // Core1 accepts the multicore lockout of Core0 until it has written the flash and cleared flash_write_pending
+    FLASH_WRITE,
+    // Flight recorder keeps DMA cycling over the buffer until FREEZE or an edge of the external trigger input
+    START_ADC_RECORD,
+    // Stop event of the flight recorder seen by Core0 at freeze_request_us
+    FREEZE,
 };
 
 enum core1_message : uint32_t {
     CORE1_STARTED = 0x80000000U,
     ADC_DONE,
+    AUTOSET_DONE,
+    CALIBRATE_DONE,
 };
 
+// Written by Core1 before AUTOSET_DONE
+extern autoset::Measurement autoset_measurement;
+
+// Written by Core0 before CALIBRATE, Core1 adds the measurement of the step before CALIBRATE_DONE
+extern volatile cal::Step calibration_step;
+extern cal::Measurement calibration_measurement;
+
+// Set by Core0 before FLASH_WRITE
+extern volatile bool flash_write_pending;
+
+// Written by Core0 before FREEZE
+extern volatile uint32_t freeze_request_us;
+
 inline bool fifo_contains_value() {
     return multicore_fifo_get_status() & SIO_FIFO_ST_VLD_BITS;
 };
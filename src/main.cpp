@@ -15,12 +15,18 @@
 #include "hardware/adc.h"
 #include "hardware/clocks.h"
 #include "hardware/pwm.h"
+#include "hardware/sync.h"
 
 #include "posc_adc.hpp"
 #include "posc_dma.hpp"
 #include "posc_pwm.hpp"
 #include "posc_trigger.hpp"
 #include "posc_dataplotter_terminal.hpp"
+#include "posc_frame_stats.hpp"
+#include "posc_frame_sizer.hpp"
+#include "posc_peak_detect.hpp"
+#include "posc_packed.hpp"
+#include "posc_calibration.hpp"
 #include "terminal_variables.hpp"
 #include "core1_main.hpp"
 
@@ -29,29 +35,113 @@ DataForCore0 datac0_glob{&datac0_mutex};
 extern DataForCore1 datac1_glob;
 
 extern debug_data_t debug_data;
-extern volatile void *ctrl_chan_adc_write;
-extern volatile bool ctrl_channel_trigered;
-extern volatile bool adc_chan_null_trigger;
-extern volatile bool dma_cycle_forever;
+extern dma::ChunkRing dma_chunk_ring;
+extern volatile float sniffed_dc_level;
+extern int dma_sync_chan;
+extern volatile uint32_t settings_latency_us;
+
+// Loaded from flash at start, Calibrate replaces the corrections of the enabled inputs
+cal::Table calibration_table;
 
 namespace s0 {
+void handle_selector_values(dt::MultiButton *selector, DataForCore1 &data_for_core1);
+
+// 200000 samples fit only in 8-bit mode, packed 12-bit mode takes a third more than 16-bit slots, every channel gets the same number of samples
+size_t get_selected_number_of_samples(const DataForCore1 &data_for_core1) {
+    const size_t number_of_samples{etl::min(s0::selector_sample_size[s0::dtsample_buff_selector.get_active_button()],
+                                            get_adc_buffer_capacity(data_for_core1.sampling_size, data_for_core1.packed))};
+    return number_of_samples - number_of_samples % data_for_core1.number_of_channels;
+}
+
+// Updates enabled channels from the toggles, returns true when their number has changed
+bool handle_channel_toggles(DataForCore1 &data_for_core1) {
+    uint32_t channel_mask{0};
+    for (size_t i{0}; i < s0::max_num_of_channels; ++i) {
+        if (s0::channel_toggles[i]->is_pressed()) channel_mask |= 1U << i;
+    }
+    if (channel_mask == 0) {
+        // At least the trigger channel stays enabled
+        const size_t trigger_channel{data_for_core1.trigger_settings.get_trigger_channel()};
+        s0::channel_toggles[trigger_channel]->button_pressed();
+        channel_mask = 1U << trigger_channel;
+    }
+
+    const uint trigger_channel{adc::get_valid_trigger_input(channel_mask, data_for_core1.trigger_settings.get_trigger_channel())};
+    if (trigger_channel != data_for_core1.trigger_settings.get_trigger_channel()) {
+        data_for_core1.trigger_settings.set_trigger_channel(trigger_channel);
+        s0::dttrigger_channel_selector.button_pressed(trigger_channel);
+    }
+
+    const uint previous_number_of_channels{data_for_core1.number_of_channels};
+    data_for_core1.channel_mask = channel_mask;
+    data_for_core1.number_of_channels = adc::get_number_of_channels(channel_mask);
+    if (previous_number_of_channels == data_for_core1.number_of_channels) {
+        return false;
+    }
+
+    s0::set_channel_strings(data_for_core1.number_of_channels);
+    s0::dtsamplerate_disp.set_value(data_for_core1.get_samplerate() / data_for_core1.number_of_channels);
+    handle_selector_values(&s0::dtsample_buff_selector, data_for_core1);
+    return true;
+}
+
 void handle_selector_values(dt::MultiButton *selector, DataForCore1 &data_for_core1) {
     if (selector == &s0::dtsamplerate_selector) {
         uint32_t adc_div_32 = adc::div_from_samplerate(s0::selector_samplerates[selector->get_active_button()]);
         s1::dtadcdiv0.set_value(adc::get_div_int_u32(adc_div_32));
         s1::dtadcdiv1.set_value(adc::get_div_frac_u32(adc_div_32));
 
-        const size_t num_of_channels = s0::dtchannel_selector.get_active_button() + 1;
-        s0::dtsamplerate_disp.set_value(adc::samplerate_form_div(adc_div_32) / num_of_channels);
+        s0::dtsamplerate_disp.set_value(adc::samplerate_form_div(adc_div_32) / data_for_core1.number_of_channels);
         s1::precise_adc_freq.set_value(adc::samplerate_form_div(adc_div_32));
         s1::dtfreq_prec0.set_value(static_cast<int32_t>(adc::samplerate_form_div(adc_div_32)));
         s1::dtfreq_prec1.set_value(0);
         data_for_core1.adc_div = adc_div_32;
+        data_for_core1.timer_samplerate = 0.0f;
     } else if (selector == &s0::dtsample_buff_selector) {
-        data_for_core1.number_of_samples = s0::selector_sample_size[selector->get_active_button()];
+        data_for_core1.number_of_samples = get_selected_number_of_samples(data_for_core1);
     } else if (selector == &s0::dttrigger_selector) {
         data_for_core1.trigger_settings.set_edge(s0::selector_edges[selector->get_active_button()]);
+    } else if (selector == &s0::dttrigger_channel_selector) {
+        // Trigger always runs on an enabled channel
+        const size_t trigger_channel{selector->get_active_button()};
+        data_for_core1.trigger_settings.set_trigger_channel(trigger_channel);
+        if (!s0::channel_toggles[trigger_channel]->is_pressed()) {
+            s0::channel_toggles[trigger_channel]->button_pressed();
+            handle_channel_toggles(data_for_core1);
+        }
+    }
+}
+
+// Trigger level goes to the middle of the probed signal, samplerate and buffer are the buttons with the smallest buffer
+// holding autoset_periods at the highest samplerate, signals without a period keep the default buttons
+void apply_autoset(const autoset::Measurement &measurement, DataForCore1 &data_for_core1) {
+    const float middle_mV{(measurement.min_level + measurement.max_level) * 0.5f * trig::Settings::max_voltage_mV};
+    data_for_core1.trigger_settings.set_level_mV(static_cast<uint16_t>(middle_mV + 0.5f));
+    s0::dttrigger_level.set_value(data_for_core1.trigger_settings.get_level());
+
+    size_t samplerate_button{s0::selector_samplerates_default}, buffer_button{s0::selector_sample_size_default};
+    if (measurement.period_s > 0.0f) {
+        const float frame_time_s{autoset_periods * measurement.period_s};
+        constexpr size_t number_of_samplerates{sizeof(s0::selector_samplerates) / sizeof(s0::selector_samplerates[0])};
+        constexpr size_t number_of_buffers{sizeof(s0::selector_sample_size) / sizeof(s0::selector_sample_size[0])};
+        bool found{false};
+        samplerate_button = 0;
+        buffer_button = number_of_buffers - 1;
+        for (size_t buffer{0}; buffer < number_of_buffers && !found; ++buffer) {
+            for (size_t samplerate{number_of_samplerates}; samplerate-- > 0;) {
+                if (s0::selector_sample_size[buffer] / s0::selector_samplerates[samplerate] >= frame_time_s) {
+                    samplerate_button = samplerate;
+                    buffer_button = buffer;
+                    found = true;
+                    break;
+                }
+            }
+        }
     }
+    s0::dtsamplerate_selector.button_pressed(samplerate_button);
+    handle_selector_values(&s0::dtsamplerate_selector, data_for_core1);
+    s0::dtsample_buff_selector.button_pressed(buffer_button);
+    handle_selector_values(&s0::dtsample_buff_selector, data_for_core1);
 }
 }  // namespace s0
 
@@ -105,12 +195,555 @@ void handle_selector_values(dt::MultiButton *selector, pwm::Manager &pwm_manager
 
 }  // namespace s2
 
+namespace s5 {
+void handle_selector_values(dt::MultiButton *selector, DataForCore1 &data_for_core1) {
+    trig::Settings &settings{data_for_core1.trigger_settings};
+    if (selector == &dttype_selector) {
+        settings.set_type(trigger_types[selector->get_active_button()]);
+    } else if (selector == &dtcondition_selector) {
+        settings.set_condition(time_conditions[selector->get_active_button()]);
+    } else if (selector == &dttime1_selector || selector == &dttime2_selector) {
+        settings.set_time_limits_us(time1_values_us[dttime1_selector.get_active_button()], time2_values_us[dttime2_selector.get_active_button()]);
+    } else if (selector == &dthysteresis_selector) {
+        settings.set_hysteresis_mV(hysteresis_values_mV[selector->get_active_button()]);
+    } else if (selector == &dtholdoff_selector) {
+        settings.set_holdoff_us(holdoff_values_us[selector->get_active_button()]);
+    }
+}
+}  // namespace s5
+
+namespace s6 {
+void handle_selector_values(dt::MultiButton *selector, DataForCore1 &data_for_core1) {
+    trig::Settings &settings{data_for_core1.trigger_settings};
+    if (selector == &dtcombination_selector) {
+        settings.set_combination(combinations[selector->get_active_button()]);
+    } else if (selector == &dttimeout_selector) {
+        settings.set_sequence_timeout_us(sequence_timeouts_us[selector->get_active_button()]);
+    } else {
+        uint channel{0};
+        for (dt::MultiButton *channel_selector : channel_selector_array) {
+            if (selector == channel_selector) {
+                settings.set_channel_condition(channel, channel_conditions[selector->get_active_button()]);
+            }
+            ++channel;
+        }
+    }
+}
+}  // namespace s6
+
+namespace s3 {
+// Capture follows the generator only while its output has periods started by DMA
+void update_generator_sync(DataForCore1 &data_for_core1, pwm::Manager &pwm_manager) {
+    data_for_core1.generator_sync = gen_sync_toggle.is_pressed() && pwm_manager.has_period_start();
+}
+
+// Core1 measures the enabled inputs while the generator holds the step signal, capture is stopped by the first step
+void measure_calibration_step(cal::Step step) {
+    busy_wait_ms(cal::settle_time_ms);
+    calibration_step = step;
+    send_msg_to_core1(CALIBRATE);
+    // Frames published before the capture stopped are dropped by Core1
+    while (get_msg_from_core1() != CALIBRATE_DONE) {
+    }
+}
+
+// Core1 is locked out in RAM, neither core may fetch code from flash while its sector is erased
+void store_calibration(cal::Table &table) {
+    flash_write_pending = true;
+    send_msg_to_core1(FLASH_WRITE);
+    multicore_lockout_start_blocking();
+    const uint32_t interrupts{save_and_disable_interrupts()};
+    cal::store_table(table);
+    restore_interrupts(interrupts);
+    multicore_lockout_end_blocking();
+    flash_write_pending = false;
+}
+
+// Generator output goes through an RC low-pass (1 kOhm, 1 uF) to the enabled inputs, its PWM gives two DC levels and its slow
+// triangle the code density, the generator gets back its function, frequency and duty afterwards
+void calibrate(pwm::Manager &pwm_manager, DataForCore1 &data_for_core1) {
+    const pwm::Manager::mode_t mode{pwm_manager.get_current_mode()};
+    const uint16_t wrap{pwm_manager.get_wrap()};
+    const pwm::div_t div{pwm_manager.get_raw_div()};
+    const int8_t duty_percent{pwm_manager.get_duty().duty_percent};
+    pwm_manager.set_wrap_for_frequency(cal::level_pwm_freq);
+    pwm_manager.set_frequency(pwm_manager.get_max_freq());
+    pwm_manager.set_duty(cal::low_duty_percent);
+    pwm_manager.enable(pwm::Manager::PWM);
+    measure_calibration_step(cal::Step::LOW);
+    pwm_manager.set_duty(cal::high_duty_percent);
+    measure_calibration_step(cal::Step::HIGH);
+    pwm_manager.set_wrap_for_func();
+    pwm_manager.enable(pwm::Manager::TRIA);
+    // Carrier of the generator runs func_pulses times faster than the triangle it outputs
+    pwm_manager.set_frequency(etl::clamp(cal::ramp_freq * pwm::Manager::func_pulses, pwm_manager.get_min_freq(), pwm_manager.get_max_freq()));
+    measure_calibration_step(cal::Step::DNL);
+    // DMA of the generator reads its tables from flash, so it stays stopped until the table is written
+    pwm_manager.enable(pwm::Manager::DISABLED);
+
+    const float low_ideal{cal::low_duty_percent * cal::codes / 100.0f}, high_ideal{cal::high_duty_percent * cal::codes / 100.0f};
+    etl::string<64> info{};
+    bool calibrated{false};
+    for (uint input{0}; input < adc::max_channels; ++input) {
+        if (!(calibration_measurement.channel_mask & (1U << input))) continue;
+        info.assign("CH");
+        etl::to_string(input + 1, info, true);
+        const float low{calibration_measurement.low[input]}, high{calibration_measurement.high[input]};
+        if (high - low < cal::min_level_distance) {
+            info.append(" is not connected to the generator");
+            dataplotter.send_warning(info.c_str(), info.size());
+            continue;
+        }
+        const cal::ChannelCorrection correction{cal::calculate(low, high, low_ideal, high_ideal, calibration_measurement.dnl[input])};
+        calibration_table.channels[input] = correction;
+        calibrated = true;
+        info.append(": offset ");
+        etl::to_string(correction.offset, info, true);
+        info.append("/16, gain ");
+        etl::to_string(correction.gain, info, true);
+        info.append("/16384");
+        dataplotter.send_info(info.c_str(), info.size());
+    }
+    if (calibrated) {
+        store_calibration(calibration_table);
+        calibration_toggle.button_pressed();
+    }
+
+    pwm_manager.set_duty(duty_percent);
+    pwm_manager.set_raw_wrap_div(wrap, div);
+    pwm_manager.enable(mode);
+    update_generator_sync(data_for_core1, pwm_manager);
+}
+}  // namespace s3
+
+// Frames of raw 12-bit codes are corrected chunk by chunk while they are sent
+cal::Corrector frame_corrector;
+inline constexpr size_t corrected_chunk_samples{256};
+
+#ifndef NDEBUG
+// Time of the correction alone, the debug screen shows its rate
+uint32_t corrected_samples{0}, correction_time_us{0};
+#endif
+
+void correct_samples(const uint16_t *input, uint16_t *output, size_t count) {
+#ifndef NDEBUG
+    const uint32_t correction_start_us{time_us_32()};
+#endif
+    frame_corrector.correct(input, output, count);
+#ifndef NDEBUG
+    corrected_samples += count;
+    correction_time_us += time_us_32() - correction_start_us;
+#endif
+}
+
+// Chunks of 16-bit frames pass through the corrector on their way to USB, 8-bit frames are never corrected
+template <typename T, typename SINK>
+auto get_corrected_sink(SINK &sink) {
+    return [&sink](const T *data, size_t length) {
+        if constexpr (sizeof(T) == sizeof(uint16_t)) {
+            if (frame_corrector.is_active()) {
+                uint16_t chunk[corrected_chunk_samples];
+                for (size_t i{0}; i < length; i += corrected_chunk_samples) {
+                    const size_t count{etl::min(length - i, corrected_chunk_samples)};
+                    correct_samples(&data[i], chunk, count);
+                    sink(chunk, count);
+                }
+                return;
+            }
+        }
+        sink(data, length);
+    };
+}
+
+template <typename T>
+void send_frame_samples(const etl::istring &channels, const DataForCore0 &frame, const float time_step, const uint8_t useful_bits, const uint32_t zero_index) {
+    const T *array1{static_cast<const T *>(frame.array1_start)};
+    const T *array2{static_cast<const T *>(frame.array2_start)};
+    const size_t pairs{s3::peak_detect_pairs[s3::dtpeak_detect_selector.get_active_button()]};
+
+    if (pairs > 0) {
+        // Long frames are reduced to min/max pairs straight from the ring, without copying
+        const dsp::PeakDetect<T> peak_detect{array1, frame.array1_samples, array2, frame.array2_samples, frame.number_of_channels, pairs};
+        if (peak_detect.is_active()) {
+            const float peak_time_step{time_step * peak_detect.get_bucket_size() / 2};
+            dataplotter.send_channel_data_chunks<T>(channels, peak_time_step, peak_detect.get_output_length(), useful_bits, 0.0f, 3.3f,
+                                                    peak_detect.get_output_index(zero_index), [&](auto &&sink) { peak_detect.run(get_corrected_sink<T>(sink)); });
+            return;
+        }
+    }
+
+    if (frame_corrector.is_active()) {
+        dataplotter.send_channel_data_chunks<T>(channels, time_step, frame.array1_samples + frame.array2_samples, useful_bits, 0.0f, 3.3f, zero_index,
+                                                [&](auto &&sink) {
+                                                    auto corrected_sink{get_corrected_sink<T>(sink)};
+                                                    corrected_sink(array1, frame.array1_samples);
+                                                    corrected_sink(array2, frame.array2_samples);
+                                                });
+    } else if (frame.array2_samples > 0) {
+        dataplotter.send_channel_data_two(channels, time_step, frame.array1_samples, frame.array2_samples, useful_bits, 0.0f, 3.3f, zero_index, array1, array2);
+    } else {
+        dataplotter.send_channel_data(channels, time_step, frame.array1_samples, useful_bits, 0.0f, 3.3f, zero_index, array1);
+    }
+}
+
+// Packed frames are unpacked chunk by chunk as they are sent, peak detection reads the packed samples in place
+inline constexpr size_t packed_send_chunk_samples{256};
+
+void send_packed_samples(const etl::istring &channels, const DataForCore0 &frame, const float time_step, const uint8_t useful_bits, const uint32_t zero_index) {
+    const dsp::Packed12View array1{frame.array1_start, frame.array1_offset};
+    const dsp::Packed12View array2{frame.array2_start};
+    const size_t pairs{s3::peak_detect_pairs[s3::dtpeak_detect_selector.get_active_button()]};
+
+    if (pairs > 0) {
+        const dsp::PeakDetect<uint16_t, dsp::Packed12View> peak_detect{array1, frame.array1_samples, array2, frame.array2_samples, frame.number_of_channels, pairs};
+        if (peak_detect.is_active()) {
+            const float peak_time_step{time_step * peak_detect.get_bucket_size() / 2};
+            dataplotter.send_channel_data_chunks<uint16_t>(channels, peak_time_step, peak_detect.get_output_length(), useful_bits, 0.0f, 3.3f,
+                                                           peak_detect.get_output_index(zero_index),
+                                                           [&](auto &&sink) { peak_detect.run(get_corrected_sink<uint16_t>(sink)); });
+            return;
+        }
+    }
+
+    dataplotter.send_channel_data_chunks<uint16_t>(
+        channels, time_step, frame.array1_samples + frame.array2_samples, useful_bits, 0.0f, 3.3f, zero_index, [&](auto &&sink) {
+            uint16_t chunk[packed_send_chunk_samples];
+            const auto send_array = [&](const dsp::Packed12View array, size_t length) {
+                for (size_t index{0}; index < length; index += packed_send_chunk_samples) {
+                    const size_t count{etl::min(length - index, packed_send_chunk_samples)};
+                    dsp::unpack12(array, index, chunk, count);
+                    if (frame_corrector.is_active()) {
+                        correct_samples(chunk, chunk, count);
+                    }
+                    sink(chunk, count);
+                }
+            };
+            send_array(array1, frame.array1_samples);
+            send_array(array2, frame.array2_samples);
+        });
+}
+
+// Segments go out one after another as a single frame, their trigger times follow as info
+template <typename T>
+void send_frame_segments(const etl::istring &channels, const DataForCore0 &frame, const float time_step, const uint8_t useful_bits, const uint32_t zero_index) {
+    uint32_t length{0};
+    for (size_t i{0}; i < frame.number_of_segments; ++i) {
+        length += frame.segments[i].array1_samples + frame.segments[i].array2_samples;
+    }
+
+    dataplotter.send_channel_data_chunks<T>(channels, time_step, length, useful_bits, 0.0f, 3.3f, zero_index, [&](auto &&sink) {
+        auto corrected_sink{get_corrected_sink<T>(sink)};
+        for (size_t i{0}; i < frame.number_of_segments; ++i) {
+            const FrameSegment &segment{frame.segments[i]};
+            corrected_sink(static_cast<const T *>(segment.array1_start), segment.array1_samples);
+            if (segment.array2_samples > 0) {
+                corrected_sink(static_cast<const T *>(segment.array2_start), segment.array2_samples);
+            }
+        }
+    });
+
+    etl::string<48> info{};
+    for (size_t i{0}; i < frame.number_of_segments; ++i) {
+        info.assign("Segment ");
+        etl::to_string(i + 1, info, true);
+        info.append(": +");
+        etl::to_string(static_cast<uint32_t>(frame.segments[i].trigger_time_us - frame.segments[0].trigger_time_us), info, true);
+        info.append(" us, dead ");
+        etl::to_string(frame.segments[i].dead_time_us, info, true);
+        info.append(" us");
+        dataplotter.send_info(info.c_str(), info.size());
+    }
+}
+
+// Deep frame is read from the ring while DMA keeps writing it, samples DMA overtook are sent as zeros and reported
+inline constexpr uint32_t deep_send_block_samples{1024};
+
+template <typename T>
+void send_deep_samples(const etl::istring &channels, const DataForCore0 &frame, const float time_step, const uint8_t useful_bits, const uint32_t zero_index) {
+    const T *const ring{static_cast<const T *>(frame.array1_start)};
+    const uint32_t ring_size{static_cast<uint32_t>(frame.array1_samples)};
+    // DMA writes the running chunk and the queued one, samples closer to it than that are not safe to read
+    const uint32_t safe_samples{ring_size - 2 * dma_chunk_max_samples};
+    uint32_t lost_samples{0};
+
+    dataplotter.send_channel_data_chunks<T>(channels, time_step, frame.deep_samples, useful_bits, 0.0f, 3.3f, zero_index, [&](auto &&raw_sink) {
+        auto sink{get_corrected_sink<T>(raw_sink)};
+        static constexpr T zeros[64]{};
+        uint32_t read_total{frame.deep_start_total}, read_index{frame.deep_start_index};
+        for (uint32_t left{frame.deep_samples}; left > 0;) {
+            uint32_t count;
+            if (lost_samples > 0 || dma_chunk_ring.get_total_written() - read_total > safe_samples) {
+                count = etl::min(left, static_cast<uint32_t>(sizeof(zeros) / sizeof(zeros[0])));
+                sink(zeros, count);
+                lost_samples += count;
+            } else {
+                const uint32_t available{dma_chunk_ring.get_total_written() - read_total};
+                count = etl::min(etl::min(available, left), etl::min(ring_size - read_index, deep_send_block_samples));
+                if (count == 0) continue;
+                sink(&ring[read_index], count);
+                // Samples DMA reached while they were being sent are not valid either
+                if (dma_chunk_ring.get_total_written() - read_total > ring_size - dma_chunk_max_samples) {
+                    lost_samples += count;
+                }
+            }
+            read_total += count;
+            read_index = (read_index + count) % ring_size;
+            left -= count;
+        }
+    });
+
+    if (lost_samples > 0) {
+        etl::string<64> warning{};
+        warning.assign("Deep capture overrun, invalid samples: ");
+        etl::to_string(lost_samples, warning, true);
+        dataplotter.send_warning(warning.c_str(), warning.size());
+    }
+}
+
+// Captured samples of the frame, peak detection may send fewer of them
+size_t get_frame_samples(const DataForCore0 &frame) {
+    if (frame.deep_samples > 0) return frame.deep_samples;
+    if (frame.number_of_segments > 1) {
+        size_t samples{0};
+        for (size_t i{0}; i < frame.number_of_segments; ++i) {
+            samples += frame.segments[i].array1_samples + frame.segments[i].array2_samples;
+        }
+        return samples;
+    }
+    return frame.array1_samples + frame.array2_samples;
+}
+
+void send_frame(const DataForCore0 &frame) {
+    float time_step = (1.0f / frame.samplerate) * frame.number_of_channels * frame.decimation_factor / frame.ets_factor;
+    uint8_t useful_bits = frame.useful_bits;
+    static uint32_t channel_mask_before = 0x1U;
+
+    // Samples are interleaved in round robin order starting with the lane of the first sample
+    etl::string<12> channels{};
+    for (uint i{0}; i < etl::max(frame.number_of_channels, 1U); ++i) {
+        if (i > 0) channels.push_back('+');
+        etl::to_string(adc::get_round_robin_input(frame.channel_mask, frame.trigger_channel, frame.first_channel + i) + 1, channels, true);
+    }
+
+    channels.push_back(',');
+
+    const uint32_t disabled_channels{channel_mask_before & ~frame.channel_mask};
+    if (disabled_channels) {
+        etl::string<12> clear_channels{};
+        for (uint i{0}; i < adc::max_channels; ++i) {
+            if (disabled_channels & (1U << i)) {
+                if (!clear_channels.empty()) clear_channels.push_back('+');
+                etl::to_string(i + 1, clear_channels, true);
+            }
+        }
+        clear_channels.push_back(',');
+        dataplotter.clear_channel_data(clear_channels);
+    }
+
+    channel_mask_before = frame.channel_mask;
+
+    const size_t trigger_div = etl::max(frame.number_of_channels, 1U);
+
+    // Correction holds for codes of the ADC scale, samples of decimated frames have more bits
+    if (s3::calibration_toggle.is_pressed() && frame.sampling_size == adc::sampling_size_t::U12 && frame.useful_bits == 12) {
+        frame_corrector.reset(calibration_table, frame.channel_mask, adc::get_round_robin_input(frame.channel_mask, frame.trigger_channel, frame.first_channel),
+                              trigger_div);
+    } else {
+        frame_corrector.disable();
+    }
+
+    if (frame.deep_samples > 0) {
+        if (frame.sampling_size == adc::sampling_size_t::U8) {
+            send_deep_samples<uint8_t>(channels, frame, time_step, useful_bits, frame.trigger_index / trigger_div);
+        } else {
+            send_deep_samples<uint16_t>(channels, frame, time_step, useful_bits, frame.trigger_index / trigger_div);
+        }
+        return;
+    }
+
+    if (frame.number_of_segments > 1) {
+        if (frame.sampling_size == adc::sampling_size_t::U8) {
+            send_frame_segments<uint8_t>(channels, frame, time_step, useful_bits, frame.segments[0].trigger_index / trigger_div);
+        } else {
+            send_frame_segments<uint16_t>(channels, frame, time_step, useful_bits, frame.segments[0].trigger_index / trigger_div);
+        }
+        return;
+    }
+
+    if (frame.packed) {
+        send_packed_samples(channels, frame, time_step, useful_bits, frame.trigger_index / trigger_div);
+        return;
+    }
+
+    // 8-bit frames go out as u1 numbers, half the bytes of the 12-bit ones
+    if (frame.sampling_size == adc::sampling_size_t::U8) {
+        send_frame_samples<uint8_t>(channels, frame, time_step, useful_bits, frame.trigger_index / trigger_div);
+    } else {
+        send_frame_samples<uint16_t>(channels, frame, time_step, useful_bits, frame.trigger_index / trigger_div);
+    }
+}
+
+// Roll and stream modes follow the ring Core1 keeps filling, only samples written since the last update are sent
+inline constexpr uint64_t roll_update_period_us{20000};
+inline constexpr uint32_t roll_max_points_per_update{400};
+inline constexpr uint32_t stream_block_samples{1024};
+inline constexpr uint32_t stream_blocks_per_update{8};
+
+struct RingReader {
+    bool active{false};
+    const void *ring;
+    uint32_t ring_size;
+    adc::sampling_size_t sampling_size;
+    uint number_of_channels;
+    uint32_t channel_mask;
+    uint first_input;
+    float time_step;
+    float volts_per_lsb;
+    uint32_t read_total, read_index, point_index;
+    uint32_t lost_samples, sent_samples;
+    uint64_t last_update_us;
+
+    // Samples written by DMA and not read yet
+    uint32_t get_available() const {
+        return dma_chunk_ring.get_total_written() - read_total;
+    }
+
+    // DMA writes the running chunk and the queued one, samples closer to it than that are not safe to read
+    uint32_t get_safe_samples() const {
+        return ring_size - 2 * dma_chunk_max_samples;
+    }
+
+    // Skips whole round robin cycles, so the next sample is always the first input
+    uint32_t skip(uint32_t samples) {
+        samples = (samples / number_of_channels) * number_of_channels;
+        read_total += samples;
+        read_index = (read_index + samples) % ring_size;
+        point_index += samples / number_of_channels;
+        return samples;
+    }
+};
+
+void start_ring_reader(RingReader &reader, const DataForCore0 &frame) {
+    reader.ring = frame.array1_start;
+    reader.ring_size = frame.array1_samples;
+    reader.sampling_size = frame.sampling_size;
+    reader.number_of_channels = etl::max(frame.number_of_channels, 1U);
+    reader.channel_mask = frame.channel_mask;
+    reader.first_input = frame.trigger_channel;
+    reader.time_step = (1.0f / frame.samplerate) * reader.number_of_channels;
+    reader.volts_per_lsb = 3.3f / ((1U << frame.useful_bits) - 1);
+    reader.read_total = 0;
+    reader.read_index = 0;
+    reader.point_index = 0;
+    reader.lost_samples = 0;
+    reader.sent_samples = 0;
+    reader.last_update_us = 0;
+    reader.active = reader.ring_size > 2 * dma_chunk_max_samples;
+}
+
+template <typename T>
+void send_roll_points(RingReader &roll, uint32_t points) {
+    const T *const ring{static_cast<const T *>(roll.ring)};
+    float values[adc::max_channels]{};
+    // Values go up to the highest enabled channel, so every channel keeps its number
+    size_t value_count{0};
+    for (uint i{0}; i < adc::max_channels; ++i) {
+        if (roll.channel_mask & (1U << i)) value_count = i + 1;
+    }
+    for (; points > 0; --points) {
+        for (uint lane{0}; lane < roll.number_of_channels; ++lane) {
+            values[adc::get_round_robin_input(roll.channel_mask, roll.first_input, lane)] = ring[roll.read_index] * roll.volts_per_lsb;
+            if (++roll.read_index == roll.ring_size) roll.read_index = 0;
+        }
+        dataplotter.send_point(roll.point_index * roll.time_step, values, value_count, roll.channel_mask);
+        ++roll.point_index;
+    }
+}
+
+void update_roll(RingReader &roll, uint64_t time_us) {
+    if (!roll.active || time_us - roll.last_update_us < roll_update_period_us) return;
+    roll.last_update_us = time_us;
+
+    uint32_t available{roll.get_available()};
+    if (available > roll.get_safe_samples()) {
+        // Roll shows the newest samples, older ones are skipped when Core0 falls behind
+        const uint32_t skipped{roll.skip(available - roll_max_points_per_update * roll.number_of_channels)};
+        available -= skipped;
+
+        etl::string<48> warning{};
+        warning.assign("Roll skipped ");
+        etl::to_string(skipped, warning, true);
+        warning.append(" samples");
+        dataplotter.send_warning(warning.c_str(), warning.size());
+    }
+
+    const uint32_t points{etl::min(available / roll.number_of_channels, roll_max_points_per_update)};
+    if (points == 0) return;
+    if (roll.sampling_size == adc::sampling_size_t::U8) {
+        send_roll_points<uint8_t>(roll, points);
+    } else {
+        send_roll_points<uint16_t>(roll, points);
+    }
+    roll.read_total += points * roll.number_of_channels;
+    dataplotter.flush();
+}
+
+// Stream blocks go out as fast as DMA fills the ring, lost samples are counted in every block header
+void update_stream(RingReader &stream) {
+    if (!stream.active) return;
+
+    const size_t bytes_per_sample{get_bytes_per_sample(stream.sampling_size)};
+    const uint32_t max_block_samples{(stream_block_samples / stream.number_of_channels) * stream.number_of_channels};
+    for (uint32_t block{0}; block < stream_blocks_per_update; ++block) {
+        uint32_t available{stream.get_available()};
+        if (available > stream.get_safe_samples()) {
+            // Overflow, stream continues from the middle of the ring and the gap shows in the sample counter
+            const uint32_t skipped{stream.skip(available - stream.ring_size / 2)};
+            stream.lost_samples += skipped;
+            available -= skipped;
+        }
+
+        const uint32_t block_samples{etl::min((available / stream.number_of_channels) * stream.number_of_channels, max_block_samples)};
+        if (block_samples == 0) break;
+
+        comm::StreamBlockHeader header{};
+        header.set(stream.read_total, stream.lost_samples, block_samples, stream.channel_mask, stream.first_input, bytes_per_sample);
+        usb_stream.send(reinterpret_cast<const uint8_t *>(&header), sizeof(header));
+
+        const uint8_t *const ring{static_cast<const uint8_t *>(stream.ring)};
+        const uint32_t first_part{etl::min(block_samples, stream.ring_size - stream.read_index)};
+        usb_stream.send(&ring[stream.read_index * bytes_per_sample], first_part * bytes_per_sample);
+        if (first_part < block_samples) {
+            usb_stream.send(ring, (block_samples - first_part) * bytes_per_sample);
+        }
+
+        // Block DMA reached while it was being sent is counted as lost, the next header shows it
+        if (dma_chunk_ring.get_total_written() - stream.read_total > stream.ring_size - dma_chunk_max_samples) {
+            stream.lost_samples += block_samples;
+        }
+        stream.skip(block_samples);
+        stream.sent_samples += block_samples;
+    }
+    usb_stream.flush();
+}
+
+uint32_t get_max_dead_time_us(const DataForCore0 &frame) {
+    uint32_t max_dead_time_us{0};
+    for (size_t i{1}; i < frame.number_of_segments; ++i) {
+        max_dead_time_us = etl::max(max_dead_time_us, frame.segments[i].dead_time_us);
+    }
+    return max_dead_time_us;
+}
+
 enum class ADCState_t : uint8_t {
     STOPPED,
     RUNNING_AUTO,
     RUNNING_NORMAL,
     WAITING,
     PAUSED,
+    ROLLING,
+    STREAMING,
+    RECORDING,
 };
 
 int main() {
@@ -124,6 +757,9 @@ int main() {
     pwm::Manager pwm_manager;
     trig::mode_t trigger_mode;
     bool force_render_static_parts{false};
+    FrameStats frame_stats;
+    FrameSizer frame_sizer;
+    RingReader ring_reader;
 
     init_dterminal();
     datac0_glob.init_mutex();
@@ -149,6 +785,16 @@ int main() {
 
     s0::dtpretrigger.set_value(datac1_private.trigger_settings.get_pretrig());
 
+    for (dt::MultiButton *selector : s5::selector_array) {
+        s5::handle_selector_values(selector, datac1_private);
+    }
+    s5::dtupper_level.set_value(datac1_private.trigger_settings.get_upper_level());
+
+    for (dt::MultiButton *selector : s6::selector_array) {
+        s6::handle_selector_values(selector, datac1_private);
+    }
+    s6::dtqualifier_level.set_value(datac1_private.trigger_settings.get_qualifier_level());
+
     s1::dtfreq_prec0.set_value(s1::precise_adc_freq.get_dec_part());
     s1::dtfreq_prec1.set_value(s1::precise_adc_freq.get_frac_part());
     s1::dtadcclk.set_value(clock_get_hz(clk_adc));
@@ -161,7 +807,11 @@ int main() {
     s2::precise_pwm_freq.set_value(pwm_manager.get_freq());
     s2::update_all_displays(pwm_manager);
 
-    datac1_private.number_of_channels = s0::dtchannel_selector.get_active_button() + 1;
+    s0::handle_channel_toggles(datac1_private);
+
+    if (cal::load_table(calibration_table)) {
+        s3::calibration_toggle.button_pressed();
+    }
 
     datac1_glob.lock_blocking();
     datac1_glob = datac1_private;
@@ -174,6 +824,8 @@ int main() {
         panic("$$XUnexpectred message form Core1");
     }
 
+    pwm_manager.chain_period_start(dma_sync_chan);
+
     pwm_manager.enable(s2::pwm_selector_modes[s2::dtpwm_func_selector.get_active_button()]);
 
     while (true) {
@@ -208,76 +860,88 @@ int main() {
                 core1_message c1msg = get_msg_from_core1();
                 if (c1msg == ADC_DONE) {
                     datac0_glob.lock_blocking();
-                    datac1_glob.lock_blocking();
-                    float time_step = (1.0f / adc::samplerate_form_div(datac1_glob.adc_div)) * datac1_glob.number_of_channels;
-                    uint8_t useful_bits = static_cast<uint8_t>(adc::sampling_size_t::U12);
-                    static uint number_of_channels_before = 1;
-
-                    etl::string<12> channels{};
-
-                    etl::to_string(datac0_glob.first_channel, channels, false);
-
-                    etl::to_string(datac0_glob.first_channel + 1, channels, false);
-                    if (datac1_glob.number_of_channels > 1) {
-                        for (uint i{1}; i < datac1_glob.number_of_channels; ++i) {
-                            channels.push_back('+');
-                            etl::to_string(((i + datac0_glob.first_channel) % datac1_glob.number_of_channels) + 1, channels, true);
+                    // Core1 replaces frames Core0 has not taken yet, an older notification may find it already sent
+                    if (datac0_glob.new_frame && datac0_glob.free_running) {
+                        start_ring_reader(ring_reader, datac0_glob);
+                        datac0_glob.new_frame = false;
+                    } else if (datac0_glob.new_frame) {
+                        const uint32_t send_start_us{time_us_32()};
+                        send_frame(datac0_glob);
+                        frame_sizer.add_sent_frame(get_frame_samples(datac0_glob), time_us_32() - send_start_us);
+                        if (frame_sizer.is_active() && datac0_glob.deep_samples == 0) {
+                            datac1_private.number_of_samples =
+                                frame_sizer.update(datac1_private.number_of_samples, s0::get_selected_number_of_samples(datac1_private),
+                                                   datac0_glob.samplerate / datac0_glob.decimation_factor, datac1_private.number_of_channels);
                         }
-                    }
-
-                    channels.push_back(',');
-
-                    if (number_of_channels_before > datac1_glob.number_of_channels && number_of_channels_before > 1) {
-                        etl::string<12> clear_channels{};
-                        etl::to_string(number_of_channels_before, clear_channels, true);
-                        uint last_channel = etl::min(datac1_glob.number_of_channels, 1U);  // Handle number_of_channels = 0
-                        for (uint i{number_of_channels_before - 1}; i > last_channel; --i) {
-                            clear_channels.push_back('+');
-                            etl::to_string(i, clear_channels, true);
+                        datac0_glob.new_frame = false;
+                        s0::dtdc_level.set_value(datac0_glob.dc_level * 3.3f);
+                        frame_stats.add_frame(datac0_glob.capture_time_us, datac0_glob.blind_time_us, datac0_glob.idle_time_us);
+                        s4::dtsegment_dead_time_us.set_value(get_max_dead_time_us(datac0_glob));
+                        if (datac0_glob.freeze_latency_us > 0) {
+                            s4::dtfreeze_latency_us.set_value(datac0_glob.freeze_latency_us);
                         }
-                        clear_channels.push_back(',');
-                        dataplotter.clear_channel_data(clear_channels);
-                    }
-
-                    number_of_channels_before = datac1_glob.number_of_channels;
-
-                    const size_t trigger_div = etl::max(datac1_glob.number_of_channels, 1U);
-
-                    if (datac0_glob.array2_samples > 0) {
-                        dataplotter.send_channel_data_two(channels, time_step, datac0_glob.array1_samples, datac0_glob.array2_samples, useful_bits, 0.0f, 3.3f,
-                                                          datac0_glob.trigger_index / trigger_div, datac0_glob.array1_start, adc_buffer_u16);
-                    } else {
-                        dataplotter.send_channel_data(channels, time_step, datac0_glob.array1_samples, useful_bits, 0.0f, 3.3f,
-                                                      datac0_glob.trigger_index / trigger_div, datac0_glob.array1_start);
-                    }
 
 #ifndef NDEBUG
-                    if (adc_state == ADCState_t::WAITING) {
-                        dataplotter.send_info("Single 1 2 TI SC AI\n");
-                        printf("%d %d %d %d %d", datac0_glob.array1_samples, datac0_glob.array2_samples, datac0_glob.trigger_index, debug_data.second_cycle,
-                               debug_data.array_index);
-                    }
-
+                        if (adc_state == ADCState_t::WAITING) {
+                            dataplotter.send_info("Single 1 2 TI SC AI\n");
+                            printf("%d %d %d %d %d", datac0_glob.array1_samples, datac0_glob.array2_samples, datac0_glob.trigger_index,
+                                   debug_data.second_cycle, debug_data.array_index);
+                        }
 #endif
 
+                        // Core1 starts next capture on its own, new settings are used from the next one
+                        datac1_glob.lock_blocking();
+                        datac1_glob = datac1_private;
+                        datac1_glob.unlock();
+                        // Edge of the external trigger input freezes the recorder without Core0
+                        if (adc_state == ADCState_t::WAITING || adc_state == ADCState_t::RECORDING) {
+                            adc_state = ADCState_t::PAUSED;
+                            s0::dttrigger_mode.set_string(s0::dttmode_hold);
+                        }
+                    }
+                    datac0_glob.unlock();
+                } else if (c1msg == AUTOSET_DONE) {
+                    // Capture restarts in AUTO mode with the new settings
+                    s0::apply_autoset(autoset_measurement, datac1_private);
+                    s0::autoset_button.button_unpressed();
+                    datac1_glob.lock_blocking();
                     datac1_glob = datac1_private;
                     datac1_glob.unlock();
-                    datac0_glob.unlock();
-                    if (adc_state == ADCState_t::RUNNING_AUTO) {
-                        send_msg_to_core1(START_ADC_AUTO);
-                        adc_state = ADCState_t::RUNNING_AUTO;
-                    } else if (adc_state == ADCState_t::RUNNING_NORMAL) {
-                        send_msg_to_core1(START_ADC_SINGLE);
-                        adc_state = ADCState_t::RUNNING_NORMAL;
-                    } else if (adc_state == ADCState_t::WAITING) {
-                        adc_state = ADCState_t::PAUSED;
-                        s0::dttrigger_mode.set_string(s0::dttmode_hold);
-                    }
+                    trigger_mode = trig::mode_t::AUTO;
+                    s0::dttrigger_mode_selector.button_pressed(0);
+                    s0::dttrigger_mode.set_string(s0::dttmode_auto);
+                    adc_state = ADCState_t::RUNNING_AUTO;
+                    send_msg_to_core1(START_ADC_AUTO);
+                }
+            }
+
+            if (adc_state == ADCState_t::ROLLING) {
+                update_roll(ring_reader, time_us_64());
+            } else if (adc_state == ADCState_t::STREAMING) {
+                update_stream(ring_reader);
+            }
+
+            if (frame_stats.update(time_us_64())) {
+                s4::dtframerate.set_value(frame_stats.get_frame_rate());
+                s4::dtblindtime.set_value(frame_stats.get_blind_time_percent());
+                s4::dtblindtime_us.set_value(frame_stats.get_blind_time_us());
+                s4::dtcore1_idle.set_value(frame_stats.get_idle_time_percent());
+                // Samples sent in the last update period of the stats
+                s4::dtstream_rate.set_value(ring_reader.sent_samples * (1e3f / FrameStats::update_period_us));
+                s4::dtstream_lost.set_value(ring_reader.lost_samples);
+                s4::dtsettings_latency_us.set_value(settings_latency_us);
+                s4::dtframe_samples.set_value(datac1_private.number_of_samples);
+                s4::dtlink_rate.set_value(frame_sizer.get_link_rate() / 1e3f);
+                ring_reader.sent_samples = 0;
+                // Roll and stream modes send no frames, DC level is taken from Core1 directly
+                if (ring_reader.active) {
+                    s0::dtdc_level.set_value(sniffed_dc_level * 3.3f);
                 }
             }
 
             rx_char = usb_stream.receive_timeout(0);
             bool force_dynamic_parts{false};
+            bool live_settings_changed{false};
             if (rx_char > 0) {
 #ifndef NDEBUG
                 dataplotter.send_info("Received char: ");
@@ -296,15 +960,21 @@ int main() {
                 } else if (rx_char == '?') {
                     dterminal.set_screen(sh::index);
                     dterminal.print_static_elements(true);
+                } else if (rx_char == s0::freeze_command || (current_screen == s0::index && rx_char == s0::freeze_button.get_button_char())) {
+                    // Frame arrives with ADC_DONE like a single capture
+                    if (adc_state == ADCState_t::RECORDING) {
+                        freeze_request_us = time_us_32();
+                        send_msg_to_core1(FREEZE);
+                        s0::dttrigger_mode.set_string(s0::dttmode_wait);
+                        adc_state = ADCState_t::WAITING;
+                    }
                 }
 #ifndef NDEBUG
                 else if (rx_char == '!') {
                     dataplotter.send_info("\nRun Trig Done\n");
                     printf("%d %d %d", debug_data.adc_running, debug_data.trigger_detected, debug_data.adc_done);
-                    dataplotter.send_info("\nCTrig Sc CW\n");
-                    printf("%d %d %p", ctrl_channel_trigered, debug_data.second_cycle, ctrl_chan_adc_write);
-                    dataplotter.send_info("\nDCF NT\n");
-                    printf("%d %d", dma_cycle_forever, adc_chan_null_trigger);
+                    dataplotter.send_info("\nSc Wraps\n");
+                    printf("%d %d", debug_data.second_cycle, dma_chunk_ring.get_wraps());
                     dataplotter.send_info("\nAtx Ctx CAdd AAdd\n");
                     printf("%d %d ", dma::get_transfer_count(debug_data.dma_adc_chan), dma::get_transfer_count(debug_data.dma_ctrl_chan));
                     printf("%x %x", dma_channel_hw_addr(debug_data.dma_adc_chan)->write_addr, dma_channel_hw_addr(debug_data.dma_ctrl_chan)->write_addr);
@@ -316,25 +986,57 @@ int main() {
                     printf("\n%d", dma_debug_hw->ch[debug_data.dma_adc_chan].tcr);
                     dataplotter.send_info("DMA FIFO\n");
                     printf("%x", dma_hw->fifo_levels);
+                    dataplotter.send_info("\nScan S us S/s\n");
+                    printf("%d %d %d", debug_data.scanned_samples, debug_data.scan_time_us,
+                           debug_data.scan_time_us ? static_cast<uint32_t>((uint64_t(debug_data.scanned_samples) * 1000000U) / debug_data.scan_time_us) : 0);
+                    dataplotter.send_info("\nDecim S us S/s\n");
+                    printf("%d %d %d", debug_data.decimated_samples, debug_data.decimation_time_us,
+                           debug_data.decimation_time_us
+                               ? static_cast<uint32_t>((uint64_t(debug_data.decimated_samples) * 1000000U) / debug_data.decimation_time_us)
+                               : 0);
+                    dataplotter.send_info("\nCorr S us S/s\n");
+                    printf("%d %d %d", corrected_samples, correction_time_us,
+                           correction_time_us ? static_cast<uint32_t>((uint64_t(corrected_samples) * 1000000U) / correction_time_us) : 0);
+                    dataplotter.send_info("\nC1 idle % S/s\n");
+                    printf("%d %d", static_cast<uint32_t>(frame_stats.get_idle_time_percent()),
+                           static_cast<uint32_t>(datac1_private.get_samplerate()));
                 }
 #endif
                 else if (current_screen == s0::index) {
                     if (rx_char == ')') {
                         datac1_private.trigger_settings.increment_level_small();
                         s0::dttrigger_level.set_value(datac1_private.trigger_settings.get_level());
+                        live_settings_changed = true;
                     } else if (rx_char == '+') {
                         datac1_private.trigger_settings.increment_level();
                         s0::dttrigger_level.set_value(datac1_private.trigger_settings.get_level());
+                        live_settings_changed = true;
                     } else if (rx_char == '(') {
                         datac1_private.trigger_settings.decrement_level_small();
                         s0::dttrigger_level.set_value(datac1_private.trigger_settings.get_level());
+                        live_settings_changed = true;
                     } else if (rx_char == '-') {
                         datac1_private.trigger_settings.decrement_level();
                         s0::dttrigger_level.set_value(datac1_private.trigger_settings.get_level());
+                        live_settings_changed = true;
+                    } else if (dt::DTButton *toggle = get_pressed_toggle(rx_char, s0::channel_toggles)) {
+                        toggle->button_toggle();
+                        if (s0::handle_channel_toggles(datac1_private)) {
+                            force_render_static_parts = true;
+                        }
+                    } else if (rx_char == s0::autoset_button.get_button_char()) {
+                        if (!s0::autoset_button.is_pressed()) {
+                            s0::autoset_button.button_pressed();
+                            ring_reader.active = false;
+                            adc_state = ADCState_t::STOPPED;
+                            send_msg_to_core1(AUTOSET);
+                        }
                     } else if (rx_char == '{') {
                         s0::dtpretrigger.set_value(datac1_private.trigger_settings.decrement_pretrig());
+                        live_settings_changed = true;
                     } else if (rx_char == '}') {
                         s0::dtpretrigger.set_value(datac1_private.trigger_settings.increment_pretrig());
+                        live_settings_changed = true;
                     } else {
                         pressed_selector = get_pressed_selector(rx_char, s0::selector_array);
                         if (pressed_selector == &s0::dttrigger_mode_selector) {
@@ -351,57 +1053,74 @@ int main() {
 
                             } else if (trigger_mode == trig::mode_t::NORM && adc_state != ADCState_t::RUNNING_NORMAL) {
                                 s0::dttrigger_mode.set_string(s0::dttmode_norm);
-                                if (adc_state != ADCState_t::WAITING) {
-                                    send_msg_to_core1(STOP_ADC);
-                                    datac1_glob.lock_blocking();
-                                    datac1_glob = datac1_private;
-                                    datac1_glob.unlock();
-                                    send_msg_to_core1(START_ADC_SINGLE);
-                                }
+                                send_msg_to_core1(STOP_ADC);
+                                datac1_glob.lock_blocking();
+                                datac1_glob = datac1_private;
+                                datac1_glob.unlock();
+                                send_msg_to_core1(START_ADC_NORMAL);
                                 adc_state = ADCState_t::RUNNING_NORMAL;
                             } else if (trigger_mode == trig::mode_t::WAIT && adc_state != ADCState_t::WAITING) {
                                 s0::dttrigger_mode.set_string(s0::dttmode_wait);
-                                if (adc_state != ADCState_t::RUNNING_NORMAL) {
-                                    send_msg_to_core1(STOP_ADC);
-                                    datac1_glob.lock_blocking();
-                                    datac1_glob = datac1_private;
-                                    datac1_glob.unlock();
-                                    send_msg_to_core1(START_ADC_SINGLE);
-                                }
+                                send_msg_to_core1(STOP_ADC);
+                                datac1_glob.lock_blocking();
+                                datac1_glob = datac1_private;
+                                datac1_glob.unlock();
+                                send_msg_to_core1(START_ADC_SINGLE);
                                 adc_state = ADCState_t::WAITING;
+                            } else if (trigger_mode == trig::mode_t::ROLL && adc_state != ADCState_t::ROLLING) {
+                                s0::dttrigger_mode.set_string(s0::dttmode_roll);
+                                send_msg_to_core1(STOP_ADC);
+                                datac1_glob.lock_blocking();
+                                datac1_glob = datac1_private;
+                                datac1_glob.unlock();
+                                ring_reader.active = false;
+                                send_msg_to_core1(START_ADC_ROLL);
+                                adc_state = ADCState_t::ROLLING;
+                            } else if (trigger_mode == trig::mode_t::STREAM && adc_state != ADCState_t::STREAMING) {
+                                s0::dttrigger_mode.set_string(s0::dttmode_stream);
+                                send_msg_to_core1(STOP_ADC);
+                                datac1_glob.lock_blocking();
+                                datac1_glob = datac1_private;
+                                datac1_glob.unlock();
+                                ring_reader.active = false;
+                                send_msg_to_core1(START_ADC_STREAM);
+                                adc_state = ADCState_t::STREAMING;
+                            } else if (trigger_mode == trig::mode_t::RECORD && adc_state != ADCState_t::RECORDING) {
+                                s0::dttrigger_mode.set_string(s0::dttmode_record);
+                                send_msg_to_core1(STOP_ADC);
+                                datac1_glob.lock_blocking();
+                                datac1_glob = datac1_private;
+                                datac1_glob.unlock();
+                                ring_reader.active = false;
+                                send_msg_to_core1(START_ADC_RECORD);
+                                adc_state = ADCState_t::RECORDING;
                             } else if (trigger_mode == trig::mode_t::HOLD && adc_state != ADCState_t::PAUSED) {
                                 s0::dttrigger_mode.set_string(s0::dttmode_hold);
                                 send_msg_to_core1(STOP_ADC);
                                 adc_state = ADCState_t::PAUSED;
                             }
-                        } else if (pressed_selector == &s0::dtchannel_selector) {
-                            const auto previous = datac1_private.number_of_channels - 1;
-                            const auto new_num_of_channels = pressed_selector->get_active_button();
-                            datac1_private.number_of_channels = new_num_of_channels + 1;
-                            if (previous != new_num_of_channels && new_num_of_channels < s0::max_num_of_channels) {
-                                s0::dtsample_buff_part.set_static_part(s0::channel_sample_buff_strs[new_num_of_channels]);
-                                s0::dtsamplerate_part.set_static_part(s0::channel_samplerate_strs[new_num_of_channels]);
-                                force_render_static_parts = true;
-
-                                uint32_t adc_div_32 = adc::div_from_samplerate(s1::precise_adc_freq.get_freq());
-                                const size_t num_of_channels = new_num_of_channels + 1;
-                                s0::dtsamplerate_disp.set_value(adc::samplerate_form_div(adc_div_32) / num_of_channels);
-                            }
+                        } else if (pressed_selector == &s0::dttrigger_channel_selector) {
+                            // Selecting a disabled channel enables it
+                            force_render_static_parts = true;
                         }
                         s0::handle_selector_values(pressed_selector, datac1_private);
+                        live_settings_changed = pressed_selector == &s0::dttrigger_selector || pressed_selector == &s0::dtsamplerate_selector;
                     }
                 } else if (current_screen == s1::index) {
                     if (rx_char == 'A') {
-                        uint32_t adc_div_32 = adc::div_from_samplerate(s1::precise_adc_freq.get_freq());
+                        const float samplerate{s1::precise_adc_freq.get_freq()};
+                        uint32_t adc_div_32 = adc::div_from_samplerate(samplerate);
                         if (!s3::div_fract_toggle.is_pressed()) {
                             adc_div_32 &= ~(ADC_DIV_FRAC_BITS);
                         }
                         s1::dtadcdiv0.set_value(adc::get_div_int_u32(adc_div_32));
                         s1::dtadcdiv1.set_value(adc::get_div_frac_u32(adc_div_32));
-                        const size_t num_of_channels = s0::dtchannel_selector.get_active_button() + 1;
-                        s0::dtsamplerate_disp.set_value(adc::samplerate_form_div(adc_div_32) / num_of_channels);
                         s0::dtsamplerate_selector.deactivate_all_buttons();
                         datac1_private.adc_div = adc_div_32;
+                        // ADC divider does not reach below about 732 S/s, Core1 paces slower conversions by a timer
+                        datac1_private.timer_samplerate = samplerate < adc::get_min_divider_samplerate() ? samplerate : 0.0f;
+                        s0::dtsamplerate_disp.set_value(datac1_private.get_samplerate() / datac1_private.number_of_channels);
+                        live_settings_changed = true;
                     } else if (rx_char == 'M' || rx_char == 'm') {
                         if (rx_char == 'M') {
                             s1::precise_adc_freq.set_max();
@@ -441,6 +1160,7 @@ int main() {
                         pressed_selector = get_pressed_selector(rx_char, s2::selector_array);
 
                         s2::handle_selector_values(pressed_selector, pwm_manager);
+                        s3::update_generator_sync(datac1_private, pwm_manager);
                     }
                 } else if (current_screen == s3::index) {
                     if (rx_char == s3::div_fract_toggle.get_button_char()) {
@@ -449,10 +1169,107 @@ int main() {
                     } else if (rx_char == s3::div_ps_toggle.get_button_char()) {
                         s3::div_ps_toggle.button_toggle();
                         gpio_put(ps_pin, !s3::div_ps_toggle.is_pressed());
+                    } else if (rx_char == s3::adc_8bit_toggle.get_button_char()) {
+                        s3::adc_8bit_toggle.button_toggle();
+                        datac1_private.sampling_size = s3::adc_8bit_toggle.is_pressed() ? adc::sampling_size_t::U8 : adc::sampling_size_t::U12;
+                        s0::handle_selector_values(&s0::dtsample_buff_selector, datac1_private);
+                    } else if (rx_char == s3::hires_toggle.get_button_char()) {
+                        s3::hires_toggle.button_toggle();
+                        datac1_private.hires = s3::hires_toggle.is_pressed();
+                    } else if (rx_char == s3::packed_toggle.get_button_char()) {
+                        s3::packed_toggle.button_toggle();
+                        datac1_private.packed = s3::packed_toggle.is_pressed();
+                        s0::handle_selector_values(&s0::dtsample_buff_selector, datac1_private);
+                    } else if (rx_char == s3::calibrate_button.get_button_char()) {
+                        s3::calibrate_button.button_pressed();
+                        ring_reader.active = false;
+                        s3::calibrate(pwm_manager, datac1_private);
+                        s3::calibrate_button.button_unpressed();
+                        // Capture restarts in AUTO mode, like after autoset
+                        datac1_glob.lock_blocking();
+                        datac1_glob = datac1_private;
+                        datac1_glob.unlock();
+                        trigger_mode = trig::mode_t::AUTO;
+                        s0::dttrigger_mode_selector.button_pressed(0);
+                        s0::dttrigger_mode.set_string(s0::dttmode_auto);
+                        adc_state = ADCState_t::RUNNING_AUTO;
+                        send_msg_to_core1(START_ADC_AUTO);
+                    } else if (rx_char == s3::calibration_toggle.get_button_char()) {
+                        s3::calibration_toggle.button_toggle();
+                    } else if (rx_char == s3::gen_sync_toggle.get_button_char()) {
+                        s3::gen_sync_toggle.button_toggle();
+                        s3::update_generator_sync(datac1_private, pwm_manager);
+                        if (s3::gen_sync_toggle.is_pressed() && !datac1_private.generator_sync) {
+                            dataplotter.send_warning("Generator sync follows only SINE and TRIA outputs");
+                        }
+                    } else {
+                        pressed_selector = get_pressed_selector(rx_char, s3::selector_array);
+                        if (pressed_selector == &s3::dtsegments_selector) {
+                            datac1_private.number_of_segments = s3::segment_counts[pressed_selector->get_active_button()];
+                        } else if (pressed_selector == &s3::dtets_selector) {
+                            datac1_private.ets_factor = s3::ets_factors[pressed_selector->get_active_button()];
+                        } else if (pressed_selector == &s3::dtaverage_selector) {
+                            datac1_private.average_count = s3::average_counts[pressed_selector->get_active_button()];
+                        } else if (pressed_selector == &s3::dttarget_fps_selector) {
+                            frame_sizer.set_target_frame_rate(s3::target_frame_rates[pressed_selector->get_active_button()]);
+                            if (!frame_sizer.is_active()) {
+                                datac1_private.number_of_samples = s0::get_selected_number_of_samples(datac1_private);
+                            }
+                        } else if (pressed_selector == &s3::dtdeep_selector) {
+                            datac1_private.deep_samples = s3::deep_sample_counts[pressed_selector->get_active_button()];
+                            if (datac1_private.deep_samples > 0 && !is_deep_capture_possible(datac1_private.get_samplerate(), datac1_private.sampling_size)) {
+                                dataplotter.send_warning("Samplerate too high for deep capture, buffer is used instead");
+                            }
+                        }
+                    }
+                } else if (current_screen == s5::index) {
+                    if (rx_char == s5::ext_trigger_toggle.get_button_char()) {
+                        s5::ext_trigger_toggle.button_toggle();
+                        datac1_private.trigger_settings.set_source(s5::ext_trigger_toggle.is_pressed() ? trig::Settings::Source::EXTERNAL
+                                                                                                       : trig::Settings::Source::CHANNEL);
+                        live_settings_changed = true;
+                    } else if (rx_char == ')' || rx_char == '+') {
+                        datac1_private.trigger_settings.increment_upper_level(rx_char == ')' ? trig::Settings::level_small_step_mV : trig::Settings::level_big_step_mV);
+                        s5::dtupper_level.set_value(datac1_private.trigger_settings.get_upper_level());
+                        live_settings_changed = true;
+                    } else if (rx_char == '(' || rx_char == '-') {
+                        datac1_private.trigger_settings.decrement_upper_level(rx_char == '(' ? trig::Settings::level_small_step_mV : trig::Settings::level_big_step_mV);
+                        s5::dtupper_level.set_value(datac1_private.trigger_settings.get_upper_level());
+                        live_settings_changed = true;
+                    } else {
+                        pressed_selector = get_pressed_selector(rx_char, s5::selector_array);
+                        s5::handle_selector_values(pressed_selector, datac1_private);
+                        live_settings_changed = pressed_selector != nullptr;
+                    }
+                } else if (current_screen == s6::index) {
+                    if (rx_char == ')' || rx_char == '+') {
+                        datac1_private.trigger_settings.increment_qualifier_level(rx_char == ')' ? trig::Settings::level_small_step_mV
+                                                                                                 : trig::Settings::level_big_step_mV);
+                        s6::dtqualifier_level.set_value(datac1_private.trigger_settings.get_qualifier_level());
+                        live_settings_changed = true;
+                    } else if (rx_char == '(' || rx_char == '-') {
+                        datac1_private.trigger_settings.decrement_qualifier_level(rx_char == '(' ? trig::Settings::level_small_step_mV
+                                                                                                 : trig::Settings::level_big_step_mV);
+                        s6::dtqualifier_level.set_value(datac1_private.trigger_settings.get_qualifier_level());
+                        live_settings_changed = true;
+                    } else {
+                        pressed_selector = get_pressed_selector(rx_char, s6::selector_array);
+                        s6::handle_selector_values(pressed_selector, datac1_private);
+                        live_settings_changed = pressed_selector != nullptr;
                     }
                 }
             }
 
+            // Running capture takes trigger and samplerate changes without a restart, the others wait for ADC_DONE
+            if (live_settings_changed &&
+                (adc_state == ADCState_t::RUNNING_AUTO || adc_state == ADCState_t::RUNNING_NORMAL || adc_state == ADCState_t::WAITING)) {
+                datac1_private.settings_time_us = time_us_32();
+                datac1_glob.lock_blocking();
+                datac1_glob = datac1_private;
+                datac1_glob.unlock();
+                send_msg_to_core1(UPDATE_SETTINGS);
+            }
+
             if (force_render_static_parts) {
                 dterminal.print_static_elements(false);
                 force_render_static_parts = false;
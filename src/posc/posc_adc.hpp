@@ -2,10 +2,13 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <etl/algorithm.h>
 #include <etl/binary.h>
 
+#include "hardware/address_mapped.h"
 #include "hardware/adc.h"
 #include "hardware/clocks.h"
+#include "hardware/timer.h"
 
 namespace adc {
 
@@ -81,22 +84,91 @@ inline uint32_t div_from_samplerate(float samplerate) {
     return div_u32_from_float(div);
 }
 
-inline uint32_t get_round_robin_mask(uint number_of_channels) {
-    if (number_of_channels > 1) {
-        number_of_channels = etl::min(number_of_channels, 4U);  // Limit to 4 channels
-        return etl::make_lsb_mask<uint32_t>(number_of_channels);
+// Slowest samplerate of the ADC clock divider, lower samplerates are paced by a timer
+inline float get_min_divider_samplerate() {
+    return static_cast<float>(clock_get_hz(clk_adc)) / adc::max_adc_div;
+}
+
+// Timer pacing interrupts Core1 on every conversion, hi-res mode averages conversions up to this rate
+inline constexpr float max_timer_conversion_rate{10000.0f};
+
+// Hardware alarm starts single conversions, results go through the FIFO and DMA the same way as in free-running mode
+class TimerPacing {
+   public:
+    // Alarm interrupt is handled by the core that calls init
+    void init(hardware_alarm_callback_t callback) {
+        _alarm = hardware_alarm_claim_unused(true);
+        hardware_alarm_set_callback(_alarm, callback);
+    }
+
+    void start(float conversion_rate) {
+        // Period in 1/256 us keeps fractional periods from drifting
+        _period_x256 = static_cast<uint64_t>(256.0e6f / conversion_rate);
+        _next_x256 = time_us_64() << 8;
+        _running = true;
+        handle_alarm();
+    }
+
+    void stop() {
+        _running = false;
+        hardware_alarm_cancel(_alarm);
+    }
+
+    void handle_alarm() {
+        if (!_running) return;
+        hw_set_bits(&adc_hw->cs, ADC_CS_START_ONCE_BITS);
+        // Periods that already passed are skipped, conversions stay on the same time grid
+        do {
+            _next_x256 += _period_x256;
+        } while (hardware_alarm_set_target(_alarm, from_us_since_boot(_next_x256 >> 8)));
+    }
+
+   private:
+    uint _alarm;
+    volatile bool _running{false};
+    uint64_t _period_x256;
+    uint64_t _next_x256;
+};
+
+inline constexpr uint max_channels{4};
+inline constexpr uint32_t all_channels_mask{etl::make_lsb_mask<uint32_t>(max_channels)};
+
+inline uint get_number_of_channels(uint32_t channel_mask) {
+    return etl::count_bits(channel_mask & all_channels_mask);
+}
+
+// Single channel is selected directly, round robin is used only for more channels
+inline uint32_t get_round_robin_mask(uint32_t channel_mask) {
+    channel_mask &= all_channels_mask;
+    if (get_number_of_channels(channel_mask) > 1) {
+        return channel_mask;
     } else {
         return 0x0U;
     }
 }
 
-inline size_t get_round_robin_index_divider(uint number_of_channels){
-    if (number_of_channels > 1) {
-        number_of_channels = etl::min(number_of_channels, 4U);  // Limit to 4 channels
-        return number_of_channels;
-    } else {
-        return 1;
+inline size_t get_round_robin_index_divider(uint32_t channel_mask) {
+    return etl::max(get_number_of_channels(channel_mask), 1U);
+}
+
+// Round robin goes from first_input through the enabled inputs in ascending order, returns the input sampled in lane
+inline uint get_round_robin_input(uint32_t channel_mask, uint first_input, size_t lane) {
+    channel_mask &= all_channels_mask;
+    uint input{first_input};
+    if (channel_mask == 0) return input;
+    for (lane %= get_number_of_channels(channel_mask); lane > 0; --lane) {
+        do {
+            input = (input + 1) % max_channels;
+        } while (!(channel_mask & (1U << input)));
     }
+    return input;
+}
+
+// Trigger input has to be enabled, otherwise the lowest enabled input is used
+inline uint get_valid_trigger_input(uint32_t channel_mask, uint trigger_input) {
+    channel_mask &= all_channels_mask;
+    if (channel_mask == 0 || (channel_mask & (1U << trigger_input))) return trigger_input;
+    return etl::count_trailing_zeros(channel_mask);
 }
 
 }  // namespace adc
\ No newline at end of file
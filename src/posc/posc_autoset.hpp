@@ -0,0 +1,63 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <etl/algorithm.h>
+
+namespace autoset {
+
+// Probe capture of one channel, levels are fractions of the ADC range
+struct Measurement {
+    float min_level{0.0f};
+    float max_level{0.0f};
+    float dc_level{0.0f};
+    // Period of the fundamental, 0 when the probe did not hold two whole periods
+    float period_s{0.0f};
+};
+
+// Two periods are three crossings of the middle level in the same direction
+inline constexpr size_t min_crossings{3};
+// Crossings count only after the signal was this fraction of the amplitude below the middle, so noise adds none
+inline constexpr uint16_t hysteresis_divider{8};
+// Smaller amplitude is treated as DC
+inline constexpr uint16_t min_amplitude_raw{40};
+
+template <typename T>
+Measurement measure(const T *samples, size_t count, float samplerate, uint16_t max_raw) {
+    Measurement result;
+    if (count == 0) return result;
+
+    T min{samples[0]}, max{samples[0]};
+    uint32_t sum{0};
+    for (size_t i{0}; i < count; ++i) {
+        min = etl::min(min, samples[i]);
+        max = etl::max(max, samples[i]);
+        sum += samples[i];
+    }
+    result.min_level = static_cast<float>(min) / max_raw;
+    result.max_level = static_cast<float>(max) / max_raw;
+    result.dc_level = static_cast<float>(sum) / count / max_raw;
+
+    const uint16_t amplitude = max - min;
+    if (amplitude < min_amplitude_raw) return result;
+
+    const uint16_t middle = min + amplitude / 2;
+    const uint16_t armed_below = middle - amplitude / hysteresis_divider;
+    bool armed{false};
+    size_t crossings{0}, first_crossing{0}, last_crossing{0};
+    for (size_t i{0}; i < count; ++i) {
+        if (samples[i] < armed_below) {
+            armed = true;
+        } else if (armed && samples[i] >= middle) {
+            armed = false;
+            if (crossings == 0) first_crossing = i;
+            last_crossing = i;
+            ++crossings;
+        }
+    }
+    if (crossings >= min_crossings) {
+        result.period_s = static_cast<float>(last_crossing - first_crossing) / (crossings - 1) / samplerate;
+    }
+    return result;
+}
+
+}  // namespace autoset
@@ -0,0 +1,71 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <etl/algorithm.h>
+
+namespace dsp {
+
+// Averages whole frames sample by sample, frames are aligned because they share the trigger index
+class FrameAverager {
+   public:
+    // Output stays below the sign bit of 16-bit lanes the trigger scanner compares
+    static constexpr uint8_t max_output_bits{15};
+
+    void reset(uint16_t *output, uint32_t *sums, size_t length, uint32_t count, uint8_t input_bits) {
+        _output = output;
+        _sums = sums;
+        _length = length;
+        _count = etl::max(count, uint32_t(1));
+        _acquisitions = 0;
+
+        // Mean of count frames gains half a bit per doubling of count
+        uint8_t log2_count{0};
+        for (uint32_t c{_count}; c > 1; c >>= 1) ++log2_count;
+        _output_bits = etl::max(input_bits, etl::min(static_cast<uint8_t>(input_bits + log2_count / 2), max_output_bits));
+        _shift = _output_bits - input_bits;
+
+        for (size_t i{0}; i < _length; ++i) {
+            _sums[i] = 0;
+        }
+    }
+
+    // Adds a frame split into two parts
+    void add(const uint16_t *array1, size_t length1, const uint16_t *array2, size_t length2) {
+        length1 = etl::min(length1, _length);
+        length2 = etl::min(length2, _length - length1);
+        uint32_t *sum{_sums};
+        for (const uint16_t *sample{array1}, *const end{array1 + length1}; sample != end; ++sample, ++sum) {
+            *sum += *sample;
+        }
+        for (const uint16_t *sample{array2}, *const end{array2 + length2}; sample != end; ++sample, ++sum) {
+            *sum += *sample;
+        }
+        ++_acquisitions;
+    }
+
+    bool is_complete() const {
+        return _acquisitions >= _count;
+    }
+
+    uint8_t get_output_bits() const {
+        return _output_bits;
+    }
+
+    void average() {
+        const uint32_t acquisitions{etl::max(_acquisitions, uint32_t(1))};
+        for (size_t i{0}; i < _length; ++i) {
+            _output[i] = static_cast<uint16_t>(((_sums[i] << _shift) + acquisitions / 2) / acquisitions);
+        }
+    }
+
+   private:
+    uint16_t *_output{nullptr};
+    uint32_t *_sums{nullptr};
+    size_t _length{0};
+    uint32_t _count{1};
+    uint32_t _acquisitions{0};
+    uint8_t _output_bits{12};
+    uint8_t _shift{0};
+};
+
+}  // namespace dsp
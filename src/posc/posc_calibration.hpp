@@ -0,0 +1,199 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <etl/algorithm.h>
+
+#include "hardware/flash.h"
+#include "posc_adc.hpp"
+
+namespace cal {
+
+inline constexpr size_t codes{4096};
+inline constexpr int32_t max_code{codes - 1};
+// Corrections are kept in 1/16 of a code, gain has 14 fractional bits
+inline constexpr uint8_t fraction_bits{4};
+inline constexpr uint8_t gain_bits{14};
+inline constexpr uint16_t unity_gain{1U << gain_bits};
+inline constexpr uint16_t min_gain{unity_gain - unity_gain / 4}, max_gain{unity_gain + unity_gain / 4};
+
+// Codes of the RP2040 ADC with the largest DNL, every code above one of them is shifted by its extra width
+inline constexpr uint16_t dnl_codes[]{512, 1536, 2560, 3584};
+inline constexpr size_t dnl_steps{sizeof(dnl_codes) / sizeof(dnl_codes[0])};
+
+// Segment of codes that share the shift, 0 is below the first DNL code
+inline constexpr size_t get_segment(uint32_t raw) {
+    return (raw + 512) >> 10;
+}
+
+// Corrected code is (raw + shift of its segment - offset) * gain
+struct ChannelCorrection {
+    int16_t offset{0};
+    uint16_t gain{unity_gain};
+    int16_t dnl[dnl_steps]{};
+};
+
+// Stored in the last flash sector, the checksum covers everything in front of it
+struct Table {
+    static constexpr uint32_t valid_magic{0x4C414345U};
+
+    uint32_t magic{valid_magic};
+    ChannelCorrection channels[adc::max_channels];
+    uint32_t checksum{0};
+
+    uint32_t calculate_checksum() const {
+        // FNV-1a
+        uint32_t hash{2166136261U};
+        const uint8_t *const bytes{reinterpret_cast<const uint8_t *>(this)};
+        for (size_t i{0}; i < offsetof(Table, checksum); ++i) {
+            hash = (hash ^ bytes[i]) * 16777619U;
+        }
+        return hash;
+    }
+};
+
+inline constexpr uint32_t flash_offset{PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE};
+static_assert(sizeof(Table) <= FLASH_PAGE_SIZE, "Calibration table has to fit one flash page");
+
+// Table that was never stored or is damaged leaves the default correction
+inline bool load_table(Table &table) {
+    const Table *const stored{reinterpret_cast<const Table *>(XIP_BASE + flash_offset)};
+    if (stored->magic != Table::valid_magic || stored->checksum != stored->calculate_checksum()) {
+        table = Table{};
+        return false;
+    }
+    table = *stored;
+    return true;
+}
+
+// Other core must not run from flash and interrupts have to be disabled while the sector is written
+inline void store_table(Table &table) {
+    table.magic = Table::valid_magic;
+    table.checksum = table.calculate_checksum();
+    uint8_t page[FLASH_PAGE_SIZE];
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, &table, sizeof(table));
+    flash_range_erase(flash_offset, FLASH_SECTOR_SIZE);
+    flash_range_program(flash_offset, page, sizeof(page));
+}
+
+// Generator output filtered to DC gives the two levels, the triangle of ramp_freq gives the code density around the DNL codes,
+// it is well below the 160 Hz corner of the 1 kOhm, 1 uF filter, which only rounds its peaks
+enum class Step : uint8_t {
+    LOW,
+    HIGH,
+    DNL,
+};
+
+inline constexpr int8_t low_duty_percent{25}, high_duty_percent{75};
+inline constexpr float level_pwm_freq{100e3f};
+// Frequency of the triangle itself, its PWM carrier is pwm::Manager::func_pulses times higher
+inline constexpr float ramp_freq{50.0f};
+inline constexpr uint32_t settle_time_ms{50};
+inline constexpr uint32_t level_samples{4096};
+inline constexpr uint32_t histogram_samples{1U << 18};
+// Inputs whose levels are closer are not connected to the generator
+inline constexpr float min_level_distance{1024.0f};
+
+struct Measurement {
+    uint32_t channel_mask{0};
+    float low[adc::max_channels]{};
+    float high[adc::max_channels]{};
+    int16_t dnl[adc::max_channels][dnl_steps]{};
+};
+
+// Neighbouring codes give the expected count, the extra count of a DNL code is its extra width
+inline constexpr size_t dnl_neighbours{32};
+inline constexpr uint32_t min_neighbour_count{8};
+
+inline void estimate_dnl(const uint16_t *histogram, int16_t *dnl) {
+    for (size_t step{0}; step < dnl_steps; ++step) {
+        const size_t code{dnl_codes[step]};
+        uint32_t sum{0};
+        for (size_t i{code - dnl_neighbours}; i <= code + dnl_neighbours; ++i) {
+            if (i != code) sum += histogram[i];
+        }
+        const float expected{static_cast<float>(sum) / (2 * dnl_neighbours)};
+        // Ramp that did not cross the code leaves it uncorrected
+        dnl[step] = expected < min_neighbour_count ? 0
+                                                   : static_cast<int16_t>((static_cast<float>(histogram[code]) / expected - 1.0f) * (1U << fraction_bits));
+    }
+}
+
+// Shift of every segment is the sum of the extra widths below it
+inline void get_segment_shifts(const ChannelCorrection &correction, int32_t *shifts) {
+    shifts[0] = 0;
+    for (size_t step{0}; step < dnl_steps; ++step) {
+        shifts[step + 1] = shifts[step] + correction.dnl[step];
+    }
+}
+
+// Ideal codes of the levels follow from the duty, the generator and the ADC reference share the 3.3 V supply
+inline ChannelCorrection calculate(float low_raw, float high_raw, float low_ideal, float high_ideal, const int16_t *dnl) {
+    ChannelCorrection correction;
+    for (size_t step{0}; step < dnl_steps; ++step) {
+        correction.dnl[step] = dnl[step];
+    }
+    int32_t shifts[dnl_steps + 1];
+    get_segment_shifts(correction, shifts);
+
+    constexpr float scale{1U << fraction_bits};
+    const float low{low_raw * scale + shifts[get_segment(static_cast<uint32_t>(low_raw))]};
+    const float high{high_raw * scale + shifts[get_segment(static_cast<uint32_t>(high_raw))]};
+    const float gain{(high_ideal - low_ideal) * scale / (high - low)};
+    correction.gain = static_cast<uint16_t>(etl::clamp(gain * unity_gain + 0.5f, static_cast<float>(min_gain), static_cast<float>(max_gain)));
+    correction.offset = static_cast<int16_t>(low - low_ideal * scale * unity_gain / correction.gain);
+    return correction;
+}
+
+// Corrects interleaved 12-bit codes while they are copied, lanes follow the round robin order of the frame
+class Corrector {
+   public:
+    void reset(const Table &table, uint32_t channel_mask, uint first_input, size_t number_of_lanes) {
+        _lanes = etl::min(number_of_lanes, size_t(adc::max_channels));
+        _lane = 0;
+        for (size_t lane{0}; lane < _lanes; ++lane) {
+            const ChannelCorrection &correction{table.channels[adc::get_round_robin_input(channel_mask, first_input, lane)]};
+            LaneCorrection &lane_correction{_lane_corrections[lane]};
+            get_segment_shifts(correction, lane_correction.add);
+            for (int32_t &add : lane_correction.add) {
+                add -= correction.offset;
+            }
+            lane_correction.gain = correction.gain;
+        }
+    }
+
+    void disable() {
+        _lanes = 0;
+    }
+
+    bool is_active() const {
+        return _lanes > 0;
+    }
+
+    // Output may be the input, the lane continues from the previous call
+    template <typename T>
+    void correct(const T *input, uint16_t *output, size_t count) {
+        for (size_t i{0}; i < count; ++i) {
+            const LaneCorrection &lane{_lane_corrections[_lane]};
+            const uint32_t raw{input[i] & 0x0FFFU};
+            const int32_t value{(((static_cast<int32_t>(raw) << fraction_bits) + lane.add[get_segment(raw)]) * lane.gain + rounding) >> shift};
+            output[i] = static_cast<uint16_t>(etl::clamp(value, int32_t(0), max_code));
+            if (++_lane == _lanes) _lane = 0;
+        }
+    }
+
+   private:
+    static constexpr uint8_t shift{fraction_bits + gain_bits};
+    static constexpr int32_t rounding{1 << (shift - 1)};
+
+    struct LaneCorrection {
+        int32_t add[dnl_steps + 1];
+        int32_t gain;
+    };
+    LaneCorrection _lane_corrections[adc::max_channels];
+    size_t _lanes{0};
+    size_t _lane{0};
+};
+
+}  // namespace cal
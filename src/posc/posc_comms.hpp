@@ -135,6 +135,35 @@ inline size_t write_escape_position(char *buff, uint32_t line, uint32_t column)
     return index;
 }
 
+// Header of a continuous stream block, samples of whole round robin cycles follow it, all numbers are little-endian
+struct StreamBlockHeader {
+    static constexpr char sync_word[4]{'E', 'L', 'S', 'B'};
+
+    char sync[4];
+    // Counter of samples since the stream has started, including the lost ones
+    uint32_t first_sample;
+    // Samples lost since the stream has started
+    uint32_t lost_samples;
+    uint16_t sample_count;
+    uint8_t channel_mask;
+    // Input of the first sample, the others follow in round robin order
+    uint8_t first_input;
+    uint8_t bytes_per_sample;
+    uint8_t reserved[3];
+
+    void set(uint32_t first, uint32_t lost, uint16_t count, uint8_t mask, uint8_t input, uint8_t sample_bytes) {
+        for (size_t i{0}; i < sizeof(sync); ++i) sync[i] = sync_word[i];
+        first_sample = first;
+        lost_samples = lost;
+        sample_count = count;
+        channel_mask = mask;
+        first_input = input;
+        bytes_per_sample = sample_bytes;
+        reserved[0] = reserved[1] = reserved[2] = 0;
+    }
+};
+static_assert(sizeof(StreamBlockHeader) == 20, "Stream block header has to stay packed");
+
 class USBStream {
    public:
     USBStream(stdio_driver_t *usb_driver) : _usb_driver{*usb_driver} {
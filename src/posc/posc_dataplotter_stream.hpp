@@ -129,6 +129,43 @@ class DataPlotterStream {
         send_channel_data_numbers_two(time_step, length1, length2, useful_bits, min, max, zero_index, data1, data2);
     }
 
+    // Data of known length are produced in chunks by generator(sink), sink(const T* data, size_t length)
+    template <typename T, typename GENERATOR>
+    void send_channel_data_chunks(const etl::istring& channel, const float time_step, const uint32_t length, const uint8_t useful_bits, const float min,
+                                  const float max, const uint32_t zero_index, GENERATOR&& generator) const {
+        constexpr char start[]{_cmd[0], _cmd[1], _cmd_channel};
+        _usb_stream.send(start, 3);
+        _usb_stream.send(channel.c_str(), channel.size());
+        send_number_bin(time_step, ',');
+        send_number_dec(length, ',');
+        send_number_dec(useful_bits, ',');
+        send_number_bin(min, ',');
+        send_number_bin(max, ',');
+        send_number_dec(zero_index, ';');
+
+        constexpr char type{get_type_character<T>()};
+        static_assert(type, "Type not supported");
+        const char buff[]{type, static_cast<const char>(sizeof(T) + '0')};
+        _usb_stream.send(buff, sizeof(buff));
+        generator([this](const T* data, size_t data_length) { _usb_stream.send(reinterpret_cast<const uint8_t*>(data), data_length * sizeof(T)); });
+        _usb_stream.send(';');
+        flush();
+    }
+
+    // Point of a scrolling plot, time goes first and channel values follow by channel number, values out of valid_mask are left empty
+    void send_point(const float time, const float* values, const size_t count, const uint32_t valid_mask) const {
+        constexpr char start[]{_cmd[0], _cmd[1], _cmd_point};
+        _usb_stream.send(start, 3);
+        send_number_bin(time);
+        for (size_t i{0}; i < count; ++i) {
+            _usb_stream.send(',');
+            if (valid_mask & (1U << i)) {
+                send_number_bin(values[i]);
+            }
+        }
+        _usb_stream.send(';');
+    }
+
     template <typename T>
     void send_channel_data_numbers(const float& time_step, const uint32_t& length, const uint8_t& useful_bits, const float& min, const float& max,
                                    const uint32_t& zero_index, const T*& data) const {
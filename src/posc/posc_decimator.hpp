@@ -0,0 +1,94 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <etl/algorithm.h>
+
+namespace dsp {
+
+// Boxcar (first order CIC) decimation of interleaved 12-bit channels, every output is the mean of factor samples of one channel
+class BoxcarDecimator {
+   public:
+    static constexpr size_t max_channels{4};
+    static constexpr uint32_t max_factor{4096};
+    static constexpr uint8_t input_bits{12};
+    // Output stays below the sign bit of 16-bit lanes the trigger scanner compares
+    static constexpr uint8_t max_output_bits{15};
+
+    // Averaging factor samples of white noise gains half a bit per doubling
+    static constexpr uint8_t get_effective_bits(uint32_t factor) {
+        uint8_t log2_factor{0};
+        while ((factor >>= 1) > 0) ++log2_factor;
+        return etl::min(static_cast<uint8_t>(input_bits + log2_factor / 2), max_output_bits);
+    }
+
+    void reset(uint32_t factor, size_t number_of_channels) {
+        _factor = etl::clamp(factor, uint32_t(1), max_factor);
+        _channels = etl::clamp(number_of_channels, size_t(1), max_channels);
+        _shift = get_effective_bits(_factor) - input_bits;
+        _round = 0;
+        _lane = 0;
+        for (uint32_t &sum : _sums) sum = 0;
+    }
+
+    uint8_t get_output_bits() const {
+        return input_bits + _shift;
+    }
+
+    // Consumes input until max_outputs samples are written, returns number of consumed input samples
+    size_t process(const uint16_t *input, size_t input_count, uint16_t *output, size_t max_outputs, size_t &output_count) {
+        output_count = 0;
+        if (_channels == 1) {
+            return process_single(input, input_count, output, max_outputs, output_count);
+        }
+
+        size_t i{0};
+        for (; i < input_count && output_count < max_outputs; ++i) {
+            _sums[_lane] += input[i];
+            // Last round of the block emits every channel in the round robin order
+            if (_round == _factor - 1) {
+                output[output_count++] = scale(_sums[_lane]);
+                _sums[_lane] = 0;
+            }
+            if (++_lane == _channels) {
+                _lane = 0;
+                if (++_round == _factor) _round = 0;
+            }
+        }
+        return i;
+    }
+
+   private:
+    size_t process_single(const uint16_t *input, size_t input_count, uint16_t *output, size_t max_outputs, size_t &output_count) {
+        size_t i{0};
+        uint32_t sum{_sums[0]};
+        while (i < input_count && output_count < max_outputs) {
+            const size_t count{etl::min(input_count - i, static_cast<size_t>(_factor - _round))};
+            for (const uint16_t *sample{&input[i]}, *const end{sample + count}; sample != end; ++sample) {
+                sum += *sample;
+            }
+            i += count;
+            _round += count;
+            if (_round == _factor) {
+                output[output_count++] = scale(sum);
+                sum = 0;
+                _round = 0;
+            }
+        }
+        _sums[0] = sum;
+        return i;
+    }
+
+    uint16_t scale(uint32_t sum) const {
+        return static_cast<uint16_t>((sum << _shift) / _factor);
+    }
+
+   private:
+    uint32_t _factor{1};
+    size_t _channels{1};
+    uint8_t _shift{0};
+    uint32_t _round{0};
+    size_t _lane{0};
+    uint32_t _sums[max_channels]{};
+};
+
+}  // namespace dsp
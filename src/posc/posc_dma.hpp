@@ -3,6 +3,7 @@
 #include <stdint.h>
 
 #include "hardware/dma.h"
+#include "hardware/sync.h"
 
 namespace dma {
 
@@ -15,4 +16,180 @@ inline uint32_t get_transfer_count(uint dma_channel) {
     return dma_channel_hw_addr(dma_channel)->transfer_count;
 }
 
+// Disabled channel ignores triggers from other channels chained to it
+inline void set_channel_enabled(uint dma_channel, bool enabled) {
+    if (enabled) {
+        hw_set_bits(&dma_channel_hw_addr(dma_channel)->al1_ctrl, DMA_CH0_CTRL_TRIG_EN_BITS);
+    } else {
+        hw_clear_bits(&dma_channel_hw_addr(dma_channel)->al1_ctrl, DMA_CH0_CTRL_TRIG_EN_BITS);
+    }
+}
+
+// Sniffer adds every sample transferred by the channel with sniffing enabled to a 32-bit sum without any CPU time
+inline void enable_sum_sniffer(uint dma_channel) {
+    dma_sniffer_enable(dma_channel, DMA_SNIFF_CTRL_CALC_VALUE_SUM, false);
+}
+
+inline void reset_sniffer_sum() {
+    dma_hw->sniff_data = 0;
+}
+
+inline uint32_t get_sniffer_sum() {
+    return dma_hw->sniff_data;
+}
+
+// Splits the DMA ring into chunks, the ADC channel chains to the control channel after every chunk
+// and the interrupt of the control channel queues the chunk after the one that has just started
+class ChunkRing {
+   public:
+    static constexpr uint32_t wrap_forever{0xFFFFFFFFU};
+
+    // Nothing is queued until start(), the first chunk is configured on the ADC channel by the caller
+    void reset(uint dma_channel, void *start, uint32_t size, uint32_t chunk_size, uint32_t bytes_per_sample, uint32_t wraps) {
+        const uint32_t interrupts{save_and_disable_interrupts()};
+        _dma_channel = dma_channel;
+        _start = static_cast<uint8_t *>(start);
+        _size = size;
+        _chunk_size = chunk_size > 0 ? chunk_size : size;
+        _bytes_per_sample = bytes_per_sample;
+        _wraps = wraps;
+        _running_offset = 0;
+        _running_length = get_chunk_length(0);
+        _queued_length = 0;
+        _written = 0;
+        _cycles = 0;
+        _total_written = 0;
+        _sniffed_sum = 0;
+        _next_write_addr = nullptr;
+        restore_interrupts(interrupts);
+    }
+
+    uint32_t get_first_length() const {
+        return _running_length;
+    }
+
+    // Control channel reads the start of the queued chunk from here into the write address trigger of the ADC channel,
+    // null stops the ring
+    const volatile void *get_next_write_addr_source() const {
+        return &_next_write_addr;
+    }
+
+    // Called after the first chunk was started
+    void start() {
+        const uint32_t interrupts{save_and_disable_interrupts()};
+        queue_next();
+        restore_interrupts(interrupts);
+    }
+
+    // Called from the interrupt of the control channel, the queued chunk is running now and the previous one is complete
+    void chunk_started() {
+        if (_running_length == 0) return;
+        // Next chunk has just started, so the sum is at most a sample or two after the end of the complete chunk
+        _sniffed_sum = get_sniffer_sum();
+        _total_written += _running_length;
+        _written = _running_offset + _running_length;
+        if (_written >= _size) {
+            _written = 0;
+            ++_cycles;
+        }
+
+        _running_offset = _queued_offset;
+        _running_length = _queued_length;
+        if (_running_length > 0 && _running_offset == 0 && _wraps != wrap_forever) {
+            --_wraps;
+        }
+        queue_next();
+    }
+
+    // Number of times DMA continues from the start of the ring before it stops at its end
+    void set_wraps(uint32_t wraps) {
+        const uint32_t interrupts{save_and_disable_interrupts()};
+        _wraps = wraps;
+        queue_next();
+        restore_interrupts(interrupts);
+    }
+
+    uint32_t get_wraps() const {
+        return _wraps;
+    }
+
+    // Chunk that is running finishes, nothing is started after it
+    void stop() {
+        const uint32_t interrupts{save_and_disable_interrupts()};
+        _wraps = 0;
+        _queued_length = 0;
+        _next_write_addr = nullptr;
+        restore_interrupts(interrupts);
+    }
+
+    // Samples of the current ring cycle in complete chunks, the number of finished ring cycles and samples since reset
+    void get_progress(uint32_t &written, uint32_t &cycles, uint32_t &total) const {
+        const uint32_t interrupts{save_and_disable_interrupts()};
+        written = _written;
+        cycles = _cycles;
+        total = _total_written;
+        restore_interrupts(interrupts);
+    }
+
+    // Sniffer sum at the end of the last complete chunk together with the samples since reset
+    void get_sniffed(uint32_t &sum, uint32_t &total) const {
+        const uint32_t interrupts{save_and_disable_interrupts()};
+        sum = _sniffed_sum;
+        total = _total_written;
+        restore_interrupts(interrupts);
+    }
+
+    // Samples written since reset up to the sample DMA writes next, the ADC channel may already run the queued chunk
+    // before its interrupt was handled
+    uint32_t get_current_total() const {
+        const uint32_t interrupts{save_and_disable_interrupts()};
+        const uint32_t write_index{(dma_channel_hw_addr(_dma_channel)->write_addr - static_cast<uint32_t>(reinterpret_cast<uintptr_t>(_start))) / _bytes_per_sample};
+        uint32_t total;
+        if (write_index >= _running_offset && write_index <= _running_offset + _running_length) {
+            total = _total_written + (write_index - _running_offset);
+        } else {
+            total = _total_written + _running_length + (write_index - _queued_offset);
+        }
+        restore_interrupts(interrupts);
+        return total;
+    }
+
+    // Samples in complete chunks since reset, read without locking from the other core
+    uint32_t get_total_written() const {
+        return _total_written;
+    }
+
+   private:
+    uint32_t get_chunk_length(uint32_t offset) const {
+        return offset + _chunk_size < _size ? _chunk_size : _size - offset;
+    }
+
+    void queue_next() {
+        if (_running_length == 0) return;
+        uint32_t offset{_running_offset + _running_length};
+        if (offset >= _size) {
+            offset = 0;
+            if (_wraps == 0) {
+                _queued_length = 0;
+                _next_write_addr = nullptr;
+                return;
+            }
+        }
+        _queued_offset = offset;
+        _queued_length = get_chunk_length(offset);
+        // Written transfer count is loaded when the control channel triggers the ADC channel again
+        dma_channel_hw_addr(_dma_channel)->transfer_count = _queued_length;
+        _next_write_addr = _start + offset * _bytes_per_sample;
+    }
+
+    uint _dma_channel{0};
+    volatile void *_next_write_addr{nullptr};
+    uint8_t *_start{nullptr};
+    uint32_t _size{0}, _chunk_size{0}, _bytes_per_sample{2};
+    volatile uint32_t _wraps{0};
+    uint32_t _running_offset{0}, _running_length{0};
+    uint32_t _queued_offset{0}, _queued_length{0};
+    volatile uint32_t _written{0}, _cycles{0}, _total_written{0}, _sniffed_sum{0};
+};
+
 }  // namespace dma
\ No newline at end of file
@@ -43,6 +43,10 @@ class DTButton : public DynamicPart {
         : DynamicPart(true, colum_pos, line_offset), _button_character(button_character), _button_is_pressed{button_is_pressed} {
     }
 
+    DTButton(DynamicPart* next, size_t colum_pos, size_t line_offset, const char button_character, bool button_is_pressed = false)
+        : DynamicPart(next, true, colum_pos, line_offset), _button_character(button_character), _button_is_pressed{button_is_pressed} {
+    }
+
     void button_pressed() {
         _button_is_pressed = true;
         _data_to_send = true;
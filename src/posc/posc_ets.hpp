@@ -0,0 +1,105 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <etl/algorithm.h>
+
+namespace ets {
+
+// Equivalent-time sampling, triggered acquisitions of a repetitive signal are placed on a grid
+// factor times finer than the ADC sample period according to the sub-sample phase of their trigger
+class Reconstructor {
+   public:
+    static constexpr uint32_t phase_one{256};
+
+    // Position of the threshold crossing between the sample before the trigger and the trigger sample,
+    // 0 is at the sample before and phase_one at the trigger sample
+    static uint32_t get_crossing_phase(uint16_t before, uint16_t trigger, uint16_t threshold) {
+        const int32_t rise{static_cast<int32_t>(trigger) - before};
+        if (rise == 0) return phase_one;
+        const int32_t phase{((static_cast<int32_t>(threshold) - before) * static_cast<int32_t>(phase_one)) / rise};
+        return static_cast<uint32_t>(etl::clamp(phase, int32_t(0), static_cast<int32_t>(phase_one)));
+    }
+
+    void reset(uint16_t *output, uint32_t *sums, uint16_t *counts, size_t points, uint32_t factor) {
+        _output = output;
+        _sums = sums;
+        _counts = counts;
+        _points = points;
+        _factor = etl::max(factor, uint32_t(1));
+        _filled = 0;
+        _acquisitions = 0;
+        for (size_t i{0}; i < _points; ++i) {
+            _sums[i] = 0;
+            _counts[i] = 0;
+        }
+    }
+
+    // Adds samples of one channel from a frame split into two parts, the channel has every stride-th sample
+    // from first_index and its trigger sample is the trigger_sample-th of them
+    void add(const uint16_t *array1, size_t length1, const uint16_t *array2, size_t length2, size_t first_index, size_t stride, size_t trigger_sample,
+             uint32_t phase) {
+        _trigger_sample = trigger_sample;
+        // Sample k lies (k - trigger_sample + 1 - phase) ADC periods after the crossing, the crossing is at trigger_sample * factor
+        const size_t phase_offset{((phase_one - phase) * _factor + phase_one / 2) / phase_one};
+        size_t point{phase_offset};
+        size_t index{first_index};
+        for (; index < length1 && point < _points; index += stride, point += _factor) {
+            add_point(point, array1[index]);
+        }
+        if (index >= length1) {
+            for (index -= length1; index < length2 && point < _points; index += stride, point += _factor) {
+                add_point(point, array2[index]);
+            }
+        }
+        ++_acquisitions;
+    }
+
+    bool is_complete() const {
+        return _filled == _points;
+    }
+
+    size_t get_acquisitions() const {
+        return _acquisitions;
+    }
+
+    size_t get_zero_index() const {
+        return etl::min(_trigger_sample * _factor, _points > 0 ? _points - 1 : 0);
+    }
+
+    // Writes the averaged waveform, points no acquisition has reached hold the previous value
+    void reconstruct() {
+        uint16_t value{0};
+        for (size_t i{0}; i < _points; ++i) {
+            if (_counts[i] > 0) {
+                value = static_cast<uint16_t>((_sums[i] + _counts[i] / 2) / _counts[i]);
+                break;
+            }
+        }
+        for (size_t i{0}; i < _points; ++i) {
+            if (_counts[i] > 0) {
+                value = static_cast<uint16_t>((_sums[i] + _counts[i] / 2) / _counts[i]);
+            }
+            _output[i] = value;
+        }
+    }
+
+   private:
+    void add_point(size_t point, uint16_t sample) {
+        if (_counts[point] == UINT16_MAX) return;
+        if (_counts[point] == 0) ++_filled;
+        _sums[point] += sample;
+        ++_counts[point];
+    }
+
+   private:
+    uint16_t *_output{nullptr};
+    uint32_t *_sums{nullptr};
+    uint16_t *_counts{nullptr};
+    size_t _points{0};
+    uint32_t _factor{1};
+    size_t _filled{0};
+    size_t _acquisitions{0};
+    size_t _trigger_sample{0};
+};
+
+}  // namespace ets
@@ -0,0 +1,54 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <etl/algorithm.h>
+
+// Adaptive frame size keeps the display at a target frame rate, the rate of the link is measured on every sent frame.
+// Capture of the next frame runs while the previous one is sent, so both have to fit in one frame period.
+class FrameSizer {
+   public:
+    // Size changes only when the new one is this factor away from the current one, so it does not oscillate
+    static constexpr float hysteresis{1.25f};
+    // Weight of the last frame in the measured link rate
+    static constexpr float rate_filter{0.25f};
+    static constexpr size_t min_samples_per_channel{100};
+
+    // Target 0 uses the selected number of samples
+    void set_target_frame_rate(float frame_rate) {
+        _target_frame_rate = frame_rate;
+    }
+
+    bool is_active() const {
+        return _target_frame_rate > 0.0f;
+    }
+
+    void add_sent_frame(size_t samples, uint32_t send_time_us) {
+        if (samples == 0 || send_time_us == 0) return;
+        const float rate{static_cast<float>(samples) * 1e6f / static_cast<float>(send_time_us)};
+        _link_rate = _link_rate > 0.0f ? _link_rate + (rate - _link_rate) * rate_filter : rate;
+    }
+
+    // Captured samples per second the link has sent
+    float get_link_rate() const {
+        return _link_rate;
+    }
+
+    // Returns the number of samples for the next frames, at most max_samples and a multiple of the number of channels
+    size_t update(size_t current_samples, size_t max_samples, float samplerate, size_t number_of_channels) {
+        if (!is_active() || _link_rate <= 0.0f) return max_samples;
+        number_of_channels = etl::max(number_of_channels, size_t(1));
+        const float frame_samples{etl::min(_link_rate, samplerate) / _target_frame_rate};
+        size_t samples{etl::clamp(static_cast<size_t>(frame_samples), min_samples_per_channel * number_of_channels, max_samples)};
+        samples -= samples % number_of_channels;
+
+        const bool outside_hysteresis{samples > current_samples * hysteresis || samples * hysteresis < current_samples};
+        if (current_samples == 0 || current_samples > max_samples || outside_hysteresis) {
+            return samples;
+        }
+        return current_samples;
+    }
+
+   private:
+    float _target_frame_rate{0.0f};
+    float _link_rate{0.0f};
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+class FrameStats {
+   public:
+    static constexpr uint64_t update_period_us{1000000};
+
+    void add_frame(uint32_t capture_time_us, uint32_t blind_time_us, uint32_t idle_time_us) {
+        ++_frames;
+        _capture_time_us += capture_time_us;
+        _blind_time_us += blind_time_us;
+        _idle_time_us += idle_time_us;
+    }
+
+    // Returns true once per update period when new values are ready
+    bool update(uint64_t time_us) {
+        const uint64_t elapsed_us{time_us - _period_start_us};
+        if (elapsed_us < update_period_us) {
+            return false;
+        }
+        _frame_rate = (static_cast<float>(_frames) * 1e6f) / static_cast<float>(elapsed_us);
+        const uint64_t sum_time_us{_capture_time_us + _blind_time_us};
+        _blind_time_percent = sum_time_us ? (static_cast<float>(_blind_time_us) * 100.0f) / static_cast<float>(sum_time_us) : 0.0f;
+        _blind_time_per_frame_us = _frames ? static_cast<uint32_t>(_blind_time_us / _frames) : 0;
+        _idle_time_percent = _capture_time_us ? (static_cast<float>(_idle_time_us) * 100.0f) / static_cast<float>(_capture_time_us) : 0.0f;
+
+        _period_start_us = time_us;
+        _frames = 0;
+        _capture_time_us = 0;
+        _blind_time_us = 0;
+        _idle_time_us = 0;
+        return true;
+    }
+
+    float get_frame_rate() const {
+        return _frame_rate;
+    }
+
+    float get_blind_time_percent() const {
+        return _blind_time_percent;
+    }
+
+    uint32_t get_blind_time_us() const {
+        return _blind_time_per_frame_us;
+    }
+
+    // Part of the capture time Core1 spent sleeping between DMA chunks
+    float get_idle_time_percent() const {
+        return _idle_time_percent;
+    }
+
+   private:
+    uint64_t _period_start_us{0};
+    uint32_t _frames{0};
+    uint64_t _capture_time_us{0};
+    uint64_t _blind_time_us{0};
+    uint64_t _idle_time_us{0};
+    float _frame_rate{0.0f};
+    float _blind_time_percent{0.0f};
+    uint32_t _blind_time_per_frame_us{0};
+    float _idle_time_percent{0.0f};
+};
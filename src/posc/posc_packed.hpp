@@ -0,0 +1,61 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+namespace dsp {
+
+// Two 12-bit samples share three bytes, the first one takes the low byte and the low nibble of the middle byte,
+// the second one the high nibble of the middle byte and the high byte
+inline constexpr size_t get_packed12_bytes(size_t number_of_samples) {
+    return (number_of_samples + 1) / 2 * 3;
+}
+
+// Reads packed samples by their index, first is the index of the sample returned for index 0
+class Packed12View {
+   public:
+    explicit constexpr Packed12View(const void *data, size_t first = 0) : _data{static_cast<const uint8_t *>(data)}, _first{first} {
+    }
+
+    uint16_t operator[](size_t index) const {
+        index += _first;
+        const uint8_t *const pair{_data + (index >> 1) * 3};
+        if (index & 1) {
+            return static_cast<uint16_t>((pair[1] >> 4) | (pair[2] << 4));
+        }
+        return static_cast<uint16_t>(pair[0] | ((pair[1] & 0x0FU) << 8));
+    }
+
+   private:
+    const uint8_t *_data;
+    size_t _first;
+};
+
+// Writes count samples from index on, a sample at an odd index completes the pair its predecessor has started
+inline void pack12(void *data, size_t index, const uint16_t *samples, size_t count) {
+    uint8_t *pair{static_cast<uint8_t *>(data) + (index >> 1) * 3};
+    if (count > 0 && (index & 1)) {
+        pair[1] = static_cast<uint8_t>((pair[1] & 0x0FU) | ((samples[0] & 0x0FU) << 4));
+        pair[2] = static_cast<uint8_t>(samples[0] >> 4);
+        ++samples;
+        --count;
+        pair += 3;
+    }
+    for (const uint16_t *const end{samples + (count & ~size_t(1))}; samples != end; samples += 2, pair += 3) {
+        const uint32_t both{samples[0] | (static_cast<uint32_t>(samples[1]) << 12)};
+        pair[0] = static_cast<uint8_t>(both);
+        pair[1] = static_cast<uint8_t>(both >> 8);
+        pair[2] = static_cast<uint8_t>(both >> 16);
+    }
+    if (count & 1) {
+        pair[0] = static_cast<uint8_t>(samples[0]);
+        pair[1] = static_cast<uint8_t>((pair[1] & 0xF0U) | (samples[0] >> 8));
+    }
+}
+
+inline void unpack12(const Packed12View packed, size_t index, uint16_t *samples, size_t count) {
+    for (size_t i{0}; i < count; ++i) {
+        samples[i] = packed[index + i];
+    }
+}
+
+}  // namespace dsp
@@ -0,0 +1,113 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <etl/algorithm.h>
+
+namespace dsp {
+
+// Reduces interleaved channels to min/max pairs per bucket, so short glitches stay visible after decimation.
+// Frame is read in place from its two ring segments, ARRAY is a pointer to them or a view of packed samples.
+template <typename T, typename ARRAY = const T *>
+class PeakDetect {
+   public:
+    static constexpr size_t max_channels{4};
+    static constexpr size_t chunk_size{64};
+
+    PeakDetect(const ARRAY array1, size_t length1, const ARRAY array2, size_t length2, size_t number_of_channels, size_t pairs)
+        : _array1{array1},
+          _array2{array2},
+          _length1{length1},
+          _channels{etl::clamp(number_of_channels, size_t(1), max_channels)},
+          _channel_samples{(length1 + length2) / _channels},
+          _bucket_size{pairs > 0 ? (_channel_samples + pairs - 1) / pairs : 1} {
+        if (_bucket_size == 0) _bucket_size = 1;
+        _buckets = (_channel_samples + _bucket_size - 1) / _bucket_size;
+    }
+
+    // Decimation is worth it only when every bucket covers more than the two output samples
+    bool is_active() const {
+        return _bucket_size > 2;
+    }
+
+    size_t get_bucket_size() const {
+        return _bucket_size;
+    }
+
+    // Number of output samples of all channels together
+    size_t get_output_length() const {
+        return _buckets * 2 * _channels;
+    }
+
+    size_t get_output_index(size_t channel_index) const {
+        return (channel_index / _bucket_size) * 2;
+    }
+
+    // Sink is called with chunks of output samples in the same channel order as the input
+    template <typename SINK>
+    void run(SINK &&sink) const {
+        T out[chunk_size];
+        size_t out_count{0};
+
+        for (size_t bucket{0}; bucket < _buckets; ++bucket) {
+            const size_t first{bucket * _bucket_size * _channels};
+            const size_t last{etl::min((bucket + 1) * _bucket_size, _channel_samples) * _channels};
+
+            T min[max_channels], max[max_channels];
+            size_t min_pos[max_channels], max_pos[max_channels];
+            for (size_t ch{0}; ch < _channels; ++ch) {
+                min[ch] = max[ch] = get(first + ch);
+                min_pos[ch] = max_pos[ch] = first;
+            }
+
+            // Bucket may be split between the end and the start of the ring
+            const size_t split{etl::clamp(_length1, first, last)};
+            scan_range(_array1, 0, first, split, min, max, min_pos, max_pos);
+            scan_range(_array2, _length1, split, last, min, max, min_pos, max_pos);
+
+            if (out_count + 2 * _channels > chunk_size) {
+                sink(out, out_count);
+                out_count = 0;
+            }
+            // Keep the order in which the extremes occurred
+            for (size_t ch{0}; ch < _channels; ++ch) {
+                out[out_count + ch] = min_pos[ch] <= max_pos[ch] ? min[ch] : max[ch];
+                out[out_count + _channels + ch] = min_pos[ch] <= max_pos[ch] ? max[ch] : min[ch];
+            }
+            out_count += 2 * _channels;
+        }
+        if (out_count > 0) {
+            sink(out, out_count);
+        }
+    }
+
+   private:
+    T get(size_t index) const {
+        return index < _length1 ? _array1[index] : _array2[index - _length1];
+    }
+
+    void scan_range(const ARRAY array, size_t offset, size_t first, size_t last, T *min, T *max, size_t *min_pos, size_t *max_pos) const {
+        size_t ch{first % _channels};
+        for (size_t i{first}; i < last; ++i) {
+            const T value{array[i - offset]};
+            if (value < min[ch]) {
+                min[ch] = value;
+                min_pos[ch] = i;
+            } else if (value > max[ch]) {
+                max[ch] = value;
+                max_pos[ch] = i;
+            }
+            if (++ch == _channels) ch = 0;
+        }
+    }
+
+   private:
+    const ARRAY _array1;
+    const ARRAY _array2;
+    const size_t _length1;
+    const size_t _channels;
+    const size_t _channel_samples;
+    size_t _bucket_size;
+    size_t _buckets;
+};
+
+}  // namespace dsp
@@ -1,6 +1,7 @@
 #pragma once
 #include <stdint.h>
 
+#include "hardware/address_mapped.h"
 #include "hardware/pwm.h"
 #include "hardware/gpio.h"
 #include "hardware/dma.h"
@@ -187,6 +188,16 @@ class Manager {
         return _current_mode;
     }
 
+    // SINE and TRIA outputs restart the table by the control channel at the start of every period
+    bool has_period_start() const {
+        return _current_mode == SINE || _current_mode == TRIA;
+    }
+
+    // Chained channel is triggered at the start of every period, it has to be disabled while it is not used
+    void chain_period_start(uint dma_channel) {
+        hw_write_masked(&dma_channel_hw_addr(_dma_ctrl_chan)->al1_ctrl, dma_channel << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB, DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS);
+    }
+
     void set_frequency(float frequency) {
         const float max_pmw_freq = get_max_freq();
         if (frequency >= max_pmw_freq) {
@@ -226,6 +237,16 @@ class Manager {
         return _div;
     }
 
+    uint16_t get_wrap() const {
+        return _wrap;
+    }
+
+    // Wrap and divider saved before give back the same frequency, the output takes them at the next enable()
+    void set_raw_wrap_div(uint16_t wrap, div_t div) {
+        _wrap = wrap;
+        _div = div;
+    }
+
     float get_freq() {
         return calculate_frequency(_wrap, _div);
     }
@@ -252,6 +273,11 @@ class Manager {
         return _duty;
     }
 
+    void set_duty(int8_t duty_percent) {
+        _duty.duty_percent = duty_percent > duty_t::duty_max ? duty_t::duty_max : (duty_percent < duty_t::duty_min ? duty_t::duty_min : duty_percent);
+        update_pwm_duty();
+    }
+
     void set_frac_div(bool allow) {
         allow_frac_div = allow;
     }
@@ -3,6 +3,7 @@
 #include <stdint.h>
 #include "pico/types.h"
 #include "posc_adc.hpp"
+#include "posc_packed.hpp"
 
 namespace trig {
 
@@ -11,6 +12,12 @@ enum class mode_t : uint8_t {
     NORM = 1,
     WAIT = 2,
     HOLD = 3,
+    // Untriggered, new samples scroll in as they are written
+    ROLL = 4,
+    // Untriggered, every sample is sent in blocks for a host-side logger
+    STREAM = 5,
+    // Untriggered, the ring runs until a stop event and the samples before it are sent
+    RECORD = 6,
 };
 
 class Settings {
@@ -30,8 +37,39 @@ class Settings {
 
     enum class Edge : uint8_t { RISING, FALLING };
 
+    // External trigger is an edge of the trigger input pin instead of the samples of the trigger channel
+    enum class Source : uint8_t { CHANNEL, EXTERNAL };
+
+    // Edge selects the polarity of pulses, runts and slopes, rising is a positive pulse and a low to high slope,
+    // window triggers on entering the window with rising and on leaving it with falling edge
+    enum class Type : uint8_t { EDGE, PULSE_WIDTH, WINDOW, RUNT, SLOPE };
+    // Pulse width and slope time are compared with time1, in range is between time1 and time2
+    enum class Condition : uint8_t { LONGER, SHORTER, IN_RANGE };
+
+    // Trigger of the trigger channel is combined with the conditions of the other enabled channels, sequence waits for
+    // a condition of another channel after the trigger and before the sequence timeout
+    enum class Combination : uint8_t { SINGLE, AND, OR, SEQUENCE };
+    // Channels compare with the qualifier level, HIGH and LOW become true by crossing it in OR and SEQUENCE
+    enum class ChannelCondition : uint8_t { ANY, HIGH, LOW, RISING, FALLING };
+
     Settings(uint16_t max_raw = max_raw_u12)
-        : _max_raw_level{max_raw}, _trigger_level_mV{500}, _pretrigger_percent(20), _trigger_edge{Edge::RISING}, _trigger_channel{0} {
+        : _max_raw_level{max_raw},
+          _trigger_level_mV{500},
+          _upper_level_mV{2500},
+          _hysteresis_mV{0},
+          _pretrigger_percent(20),
+          _trigger_edge{Edge::RISING},
+          _trigger_channel{0},
+          _type{Type::EDGE},
+          _condition{Condition::LONGER},
+          _time1_us{10},
+          _time2_us{100},
+          _holdoff_us{0},
+          _combination{Combination::SINGLE},
+          _channel_conditions{ChannelCondition::ANY, ChannelCondition::ANY, ChannelCondition::ANY, ChannelCondition::ANY},
+          _qualifier_level_mV{1600},
+          _sequence_timeout_us{1000},
+          _source{Source::CHANNEL} {
         set_raw_level();
     }
 
@@ -60,35 +98,141 @@ class Settings {
     }
 
     void increment_level(uint16_t increment = level_big_step_mV) {
-        uint16_t new_level{_trigger_level_mV};
-        if (increment >= max_trigger_level_mV) {
-            new_level = max_trigger_level_mV;
-        } else if (max_trigger_level_mV - increment < new_level) {
-            new_level = max_trigger_level_mV;
-        } else if (increment > 0) {
-            new_level = (new_level + increment) - (new_level % increment);
-        }
-        _trigger_level_mV = etl::min(max_trigger_level_mV, new_level);
+        _trigger_level_mV = step_up(_trigger_level_mV, increment);
         set_raw_level();
     }
 
     void decrement_level(uint16_t decrement = level_big_step_mV) {
-        uint16_t new_level{_trigger_level_mV};
-        if (decrement >= max_trigger_level_mV) {
-            new_level = min_trigger_level_mV;
-        } else if (min_trigger_level_mV + decrement > new_level) {
-            new_level = min_trigger_level_mV;
-        } else if (decrement > 0) {
-            if (new_level % decrement == 0) {
-                new_level -= decrement;
-            } else {
-                new_level = (new_level - new_level % decrement);
-            }
-        }
-        _trigger_level_mV = etl::max(min_trigger_level_mV, new_level);
+        _trigger_level_mV = step_down(_trigger_level_mV, decrement);
+        set_raw_level();
+    }
+
+    void set_level_mV(uint16_t level_mV) {
+        _trigger_level_mV = etl::clamp(level_mV, min_trigger_level_mV, max_trigger_level_mV);
         set_raw_level();
     }
 
+    // Upper level of window, runt and slope triggers, the trigger level is the lower one
+    float get_upper_level() const {
+        return static_cast<float>(_upper_level_mV) / 1000.0f;
+    }
+
+    void increment_upper_level(uint16_t increment = level_big_step_mV) {
+        _upper_level_mV = step_up(_upper_level_mV, increment);
+        set_raw_level();
+    }
+
+    void decrement_upper_level(uint16_t decrement = level_big_step_mV) {
+        _upper_level_mV = step_down(_upper_level_mV, decrement);
+        set_raw_level();
+    }
+
+    uint16_t get_lower_level_raw() const {
+        return etl::min(_trigger_level_raw, _upper_level_raw);
+    }
+
+    uint16_t get_upper_level_raw() const {
+        return etl::max(_trigger_level_raw, _upper_level_raw);
+    }
+
+    // Signal has to return this far behind the level before the next crossing counts
+    void set_hysteresis_mV(uint16_t hysteresis_mV) {
+        _hysteresis_mV = etl::min(hysteresis_mV, max_voltage_mV);
+        set_raw_level();
+    }
+
+    uint16_t get_hysteresis_raw() const {
+        return _hysteresis_raw;
+    }
+
+    void set_type(Type type) {
+        _type = type;
+    }
+
+    Type get_type() const {
+        return _type;
+    }
+
+    void set_condition(Condition condition) {
+        _condition = condition;
+    }
+
+    Condition get_condition() const {
+        return _condition;
+    }
+
+    void set_time_limits_us(uint32_t time1_us, uint32_t time2_us) {
+        _time1_us = time1_us;
+        _time2_us = time2_us;
+    }
+
+    uint32_t get_time1_us() const {
+        return _time1_us;
+    }
+
+    uint32_t get_time2_us() const {
+        return _time2_us;
+    }
+
+    // Trigger closer than holdoff to the previous one is not accepted
+    void set_holdoff_us(uint32_t holdoff_us) {
+        _holdoff_us = holdoff_us;
+    }
+
+    uint32_t get_holdoff_us() const {
+        return _holdoff_us;
+    }
+
+    void set_combination(Combination combination) {
+        _combination = combination;
+    }
+
+    Combination get_combination() const {
+        return _combination;
+    }
+
+    void set_channel_condition(uint channel, ChannelCondition condition) {
+        if (channel < 4) _channel_conditions[channel] = condition;
+    }
+
+    ChannelCondition get_channel_condition(uint channel) const {
+        return channel < 4 ? _channel_conditions[channel] : ChannelCondition::ANY;
+    }
+
+    float get_qualifier_level() const {
+        return static_cast<float>(_qualifier_level_mV) / 1000.0f;
+    }
+
+    void increment_qualifier_level(uint16_t increment = level_big_step_mV) {
+        _qualifier_level_mV = step_up(_qualifier_level_mV, increment);
+        set_raw_level();
+    }
+
+    void decrement_qualifier_level(uint16_t decrement = level_big_step_mV) {
+        _qualifier_level_mV = step_down(_qualifier_level_mV, decrement);
+        set_raw_level();
+    }
+
+    uint16_t get_qualifier_level_raw() const {
+        return _qualifier_level_raw;
+    }
+
+    void set_sequence_timeout_us(uint32_t timeout_us) {
+        _sequence_timeout_us = timeout_us;
+    }
+
+    uint32_t get_sequence_timeout_us() const {
+        return _sequence_timeout_us;
+    }
+
+    void set_source(Source source) {
+        _source = source;
+    }
+
+    Source get_source() const {
+        return _source;
+    }
+
     uint8_t increment_pretrig() {
         if (_pretrigger_percent < max_pretrig) {
             _pretrigger_percent += pretrig_step;
@@ -125,6 +269,20 @@ class Settings {
         set_raw_level();
     }
 
+    void set_resolution_bits(uint8_t bits) {
+        _max_raw_level = static_cast<uint16_t>((1U << bits) - 1U);
+        set_raw_level();
+    }
+
+    uint16_t get_max_raw_level() const {
+        return _max_raw_level;
+    }
+
+    uint16_t get_scan_threshold() const {
+        // Falling edge is "above level" -> "at or below level", so the scanner compares against level + 1
+        return _trigger_edge == Edge::FALLING ? _trigger_level_raw + 1 : _trigger_level_raw;
+    }
+
     uint16_t get_initial_sample_value() const {
         if (_trigger_edge == Edge::FALLING) {
             return min_raw;
@@ -141,22 +299,467 @@ class Settings {
         if (channel < 4) _trigger_channel = channel;
     }
 
-    uint get_trigger_channel() {
+    uint get_trigger_channel() const {
         return _trigger_channel;
     }
 
    private:
+    static uint16_t step_up(uint16_t level_mV, uint16_t increment) {
+        uint16_t new_level{level_mV};
+        if (increment >= max_trigger_level_mV) {
+            new_level = max_trigger_level_mV;
+        } else if (max_trigger_level_mV - increment < new_level) {
+            new_level = max_trigger_level_mV;
+        } else if (increment > 0) {
+            new_level = (new_level + increment) - (new_level % increment);
+        }
+        return etl::min(max_trigger_level_mV, new_level);
+    }
+
+    static uint16_t step_down(uint16_t level_mV, uint16_t decrement) {
+        uint16_t new_level{level_mV};
+        if (decrement >= max_trigger_level_mV) {
+            new_level = min_trigger_level_mV;
+        } else if (min_trigger_level_mV + decrement > new_level) {
+            new_level = min_trigger_level_mV;
+        } else if (decrement > 0) {
+            if (new_level % decrement == 0) {
+                new_level -= decrement;
+            } else {
+                new_level = (new_level - new_level % decrement);
+            }
+        }
+        return etl::max(min_trigger_level_mV, new_level);
+    }
+
+    uint16_t raw_from_mV(uint16_t mV) const {
+        uint32_t temp = (static_cast<uint32_t>(_max_raw_level) * mV) / (max_voltage_mV / 10);
+        return (temp + 5U) / 10U;
+    }
+
     void set_raw_level() {
-        uint32_t temp = (static_cast<uint32_t>(_max_raw_level) * _trigger_level_mV) / (max_voltage_mV / 10);
-        _trigger_level_raw = (temp + 5U) / 10U;
+        _trigger_level_raw = raw_from_mV(_trigger_level_mV);
+        _upper_level_raw = raw_from_mV(_upper_level_mV);
+        _hysteresis_raw = raw_from_mV(_hysteresis_mV);
+        _qualifier_level_raw = raw_from_mV(_qualifier_level_mV);
     }
 
    private:
     uint16_t _max_raw_level;
     uint16_t _trigger_level_mV;
     uint16_t _trigger_level_raw;
+    uint16_t _upper_level_mV;
+    uint16_t _upper_level_raw;
+    uint16_t _hysteresis_mV;
+    uint16_t _hysteresis_raw;
     uint8_t _pretrigger_percent;
     Edge _trigger_edge;
     uint _trigger_channel;
+    Type _type;
+    Condition _condition;
+    uint32_t _time1_us;
+    uint32_t _time2_us;
+    uint32_t _holdoff_us;
+    Combination _combination;
+    ChannelCondition _channel_conditions[4];
+    uint16_t _qualifier_level_mV;
+    uint16_t _qualifier_level_raw;
+    uint32_t _sequence_timeout_us;
+    Source _source;
+};
+
+class BlockScanner {
+   public:
+    using Edge = Settings::Edge;
+    using Type = Settings::Type;
+    using Condition = Settings::Condition;
+    using Combination = Settings::Combination;
+    using ChannelCondition = Settings::ChannelCondition;
+    static constexpr size_t no_trigger{SIZE_MAX};
+
+    // Round robin of the buffer starts with first_input, conditions of the other channels are read from the same cycle,
+    // so the buffer has to hold whole cycles
+    void set_channels(uint32_t channel_mask, uint first_input) {
+        _channel_mask = channel_mask;
+        _first_input = first_input;
+    }
+
+    // Times of the settings are converted to samples of the trigger channel at trigger_samplerate
+    void reset(const Settings &settings, size_t first_index, size_t stride, float trigger_samplerate) {
+        update(settings, trigger_samplerate);
+        _next_index = first_index;
+        _stride = stride > 0 ? stride : 1;
+    }
+
+    // Scans every trigger channel sample from the last position up to (not including) end_index,
+    // buffer is a pointer to the samples or a view of packed ones
+    template <typename BUFFER>
+    size_t scan(const BUFFER buffer, size_t end_index) {
+        if (_qualifier_count > 0) {
+            switch (_type) {
+                case Type::PULSE_WIDTH:
+                    return scan_combined<Type::PULSE_WIDTH>(buffer, end_index);
+                case Type::WINDOW:
+                    return scan_combined<Type::WINDOW>(buffer, end_index);
+                case Type::RUNT:
+                    return scan_combined<Type::RUNT>(buffer, end_index);
+                case Type::SLOPE:
+                    return scan_combined<Type::SLOPE>(buffer, end_index);
+                default:
+                    return scan_combined<Type::EDGE>(buffer, end_index);
+            }
+        }
+        switch (_type) {
+            case Type::PULSE_WIDTH:
+                return scan_states<Type::PULSE_WIDTH>(buffer, end_index);
+            case Type::WINDOW:
+                return scan_states<Type::WINDOW>(buffer, end_index);
+            case Type::RUNT:
+                return scan_states<Type::RUNT>(buffer, end_index);
+            case Type::SLOPE:
+                return scan_states<Type::SLOPE>(buffer, end_index);
+            default:
+                break;
+        }
+        if (_hysteresis > 0) {
+            return scan_states<Type::EDGE>(buffer, end_index);
+        } else if (_edge == Edge::RISING) {
+            return scan_edge<Edge::RISING>(buffer, end_index);
+        } else {
+            return scan_edge<Edge::FALLING>(buffer, end_index);
+        }
+    }
+
+    // Settings change from the current position, the next samples only set the state before a trigger can be found,
+    // times are converted at the samplerate of the trigger channel the next samples have
+    void update(const Settings &settings, float trigger_samplerate) {
+        _samples_per_us = trigger_samplerate / 1000000.0f;
+        _edge = settings.get_edge();
+        _type = settings.get_type();
+        _condition = settings.get_condition();
+        _threshold = settings.get_scan_threshold();
+        _above = settings.get_initial_sample_value() >= _threshold;
+        _hysteresis = settings.get_hysteresis_raw();
+
+        // Falling polarity is scanned as rising on inverted samples, window keeps the levels and uses the edge for enter or exit
+        const uint16_t max_raw{settings.get_max_raw_level()};
+        _invert = _type != Type::WINDOW && _edge == Edge::FALLING ? max_raw : 0;
+        const uint16_t level{settings.get_level_raw()}, lower{settings.get_lower_level_raw()}, upper{settings.get_upper_level_raw()};
+        if (_invert) {
+            // Sample at or below a level is at or above the inverted one
+            _level = max_raw - level;
+            _lower = max_raw - upper;
+            _upper = max_raw - lower;
+        } else {
+            _level = level;
+            _lower = lower;
+            _upper = upper;
+        }
+        _time1 = static_cast<uint32_t>(static_cast<float>(settings.get_time1_us()) * _samples_per_us + 0.5f);
+        _time2 = static_cast<uint32_t>(static_cast<float>(settings.get_time2_us()) * _samples_per_us + 0.5f);
+        _state = State::IDLE;
+
+        _combination = settings.get_combination();
+        _qualifier_count = 0;
+        if (_combination != Combination::SINGLE) {
+            const size_t lanes{adc::get_round_robin_index_divider(_channel_mask)};
+            for (size_t lane{1}; lane < lanes; ++lane) {
+                const ChannelCondition condition{settings.get_channel_condition(adc::get_round_robin_input(_channel_mask, _first_input, lane))};
+                if (condition != ChannelCondition::ANY) {
+                    _qualifiers[_qualifier_count++] = {static_cast<uint8_t>(lane), condition, false};
+                }
+            }
+        }
+        _qualifier_level = settings.get_qualifier_level_raw();
+        _timeout = static_cast<uint32_t>(static_cast<float>(settings.get_sequence_timeout_us()) * _samples_per_us + 0.5f);
+        _qualifiers_valid = false;
+        _sequence_armed = false;
+    }
+
+    // At least count samples are left out from the search, the channel order stays the same
+    void skip(size_t count) {
+        _next_index += ((count + _stride - 1) / _stride) * _stride;
+        _state = State::IDLE;
+        _qualifiers_valid = false;
+        _sequence_armed = false;
+    }
+
+    // Buffer was restarted from index 0, continue with the same channel order
+    void wrap(size_t buffer_size) {
+        _next_index = _next_index >= buffer_size ? _next_index - buffer_size : 0;
+    }
+
+    size_t get_next_index() const {
+        return _next_index;
+    }
+
+   private:
+    // IDLE has no sample yet, ARMED is below the level with hysteresis, ACTIVE is inside a pulse, runt, slope or the window
+    // and WAITING has to return below the level first or is outside the window
+    enum class State : uint8_t { IDLE, ARMED, WAITING, ACTIVE };
+
+    bool time_matches(uint32_t duration) const {
+        if (_condition == Condition::LONGER) {
+            return duration > _time1;
+        } else if (_condition == Condition::SHORTER) {
+            return duration < _time1;
+        }
+        return duration >= _time1 && duration <= _time2;
+    }
+
+    // Returns true when the sample completes a trigger, rising polarity only, samples of falling polarity are inverted
+    template <Type TYPE>
+    bool step(uint16_t sample) {
+        ++_sample_count;
+        if constexpr (TYPE == Type::EDGE) {
+            if (sample + _hysteresis < _level) {
+                _state = State::ARMED;
+            } else if (_state == State::ARMED && sample >= _level) {
+                _state = State::WAITING;
+                return true;
+            }
+        } else if constexpr (TYPE == Type::PULSE_WIDTH) {
+            if (_state == State::ACTIVE) {
+                if (sample + _hysteresis < _level) {
+                    _state = State::ARMED;
+                    return time_matches(_sample_count - _start_count);
+                }
+            } else if (sample + _hysteresis < _level) {
+                _state = State::ARMED;
+            } else if (_state == State::ARMED && sample >= _level) {
+                _state = State::ACTIVE;
+                _start_count = _sample_count;
+            }
+        } else if constexpr (TYPE == Type::WINDOW) {
+            const State inside{sample >= _lower && sample < _upper ? State::ACTIVE : State::WAITING};
+            const bool changed{_state != State::IDLE && inside != _state};
+            _state = inside;
+            return changed && (inside == State::ACTIVE) == (_edge == Edge::RISING);
+        } else if constexpr (TYPE == Type::RUNT) {
+            // Runt crosses the lower level and returns below it without reaching the upper one
+            if (sample + _hysteresis < _lower) {
+                const bool runt{_state == State::ACTIVE};
+                _state = State::ARMED;
+                return runt;
+            } else if (sample >= _upper) {
+                _state = State::WAITING;
+            } else if (_state == State::ARMED && sample >= _lower) {
+                _state = State::ACTIVE;
+            }
+        } else if constexpr (TYPE == Type::SLOPE) {
+            // Slope time is measured from the lower level to the upper one
+            if (sample < _lower) {
+                _state = State::ARMED;
+            } else if (_state == State::ARMED) {
+                _state = State::ACTIVE;
+                _start_count = _sample_count;
+            }
+            if (_state == State::ACTIVE && sample >= _upper) {
+                _state = State::WAITING;
+                return time_matches(_sample_count - _start_count);
+            }
+        }
+        return false;
+    }
+
+    template <Type TYPE, typename BUFFER>
+    size_t scan_states(const BUFFER buffer, const size_t end_index) {
+        size_t index{_next_index};
+        for (; index < end_index; index += _stride) {
+            if (step<TYPE>(buffer[index] ^ _invert)) return found(index);
+        }
+        _next_index = index;
+        return no_trigger;
+    }
+
+    // Evaluates the other channels of the cycle starting at index
+    template <typename BUFFER>
+    void step_qualifiers(const BUFFER buffer, size_t index, bool &all_true, bool &any_became_true) {
+        all_true = true;
+        any_became_true = false;
+        for (size_t i{0}; i < _qualifier_count; ++i) {
+            Qualifier &qualifier{_qualifiers[i]};
+            const bool above{buffer[index + qualifier.lane] >= _qualifier_level};
+            const bool rose{_qualifiers_valid && above && !qualifier.above};
+            const bool fell{_qualifiers_valid && !above && qualifier.above};
+            qualifier.above = above;
+
+            bool is_true{false}, became_true{false};
+            switch (qualifier.condition) {
+                case ChannelCondition::HIGH:
+                    is_true = above;
+                    became_true = rose;
+                    break;
+                case ChannelCondition::LOW:
+                    is_true = !above;
+                    became_true = fell;
+                    break;
+                case ChannelCondition::RISING:
+                    is_true = became_true = rose;
+                    break;
+                case ChannelCondition::FALLING:
+                    is_true = became_true = fell;
+                    break;
+                default:
+                    is_true = true;
+                    break;
+            }
+            all_true = all_true && is_true;
+            any_became_true = any_became_true || became_true;
+        }
+        _qualifiers_valid = true;
+    }
+
+    // Trigger index is the trigger channel sample of the cycle in which the combination became true
+    template <Type TYPE, typename BUFFER>
+    size_t scan_combined(const BUFFER buffer, const size_t end_index) {
+        // Whole cycle has to be written
+        const size_t cycle_end{end_index >= _stride ? end_index - (_stride - 1) : 0};
+        size_t index{_next_index};
+        for (; index < cycle_end; index += _stride) {
+            const bool triggered{step<TYPE>(buffer[index] ^ _invert)};
+            bool all_true, any_became_true;
+            step_qualifiers(buffer, index, all_true, any_became_true);
+
+            if (_combination == Combination::AND) {
+                if (triggered && all_true) return found(index);
+            } else if (_combination == Combination::OR) {
+                if (triggered || any_became_true) return found(index);
+            } else {
+                if (_sequence_armed && ++_sequence_count > _timeout) {
+                    _sequence_armed = false;
+                }
+                if (_sequence_armed && any_became_true) {
+                    _sequence_armed = false;
+                    return found(index);
+                }
+                if (triggered) {
+                    _sequence_armed = true;
+                    _sequence_count = 0;
+                }
+            }
+        }
+        _next_index = index;
+        return no_trigger;
+    }
+
+    template <Edge EDGE>
+    bool crossed(uint16_t sample) {
+        const bool above{sample >= _threshold};
+        const bool crossing{EDGE == Edge::RISING ? (!_above && above) : (_above && !above)};
+        _above = above;
+        return crossing;
+    }
+
+    template <typename T>
+    static constexpr uint32_t lane_sign_bits() {
+        return sizeof(T) == 1 ? 0x80808080U : 0x80008000U;
+    }
+
+    template <typename T>
+    static constexpr uint32_t broadcast(uint32_t value) {
+        return sizeof(T) == 1 ? value * 0x01010101U : value * 0x00010001U;
+    }
+
+    // Sign bit of each lane is set when the sample is >= threshold
+    template <typename T>
+    uint32_t lanes_above(uint32_t word) const {
+        constexpr uint32_t sign_bits{lane_sign_bits<T>()};
+        if constexpr (sizeof(T) == 1) {
+            // 8-bit samples use the whole lane, the top bit is compared separately
+            const uint32_t low_above{((word | sign_bits) - broadcast<T>(_threshold & 0x7FU)) & sign_bits};
+            return (_threshold & 0x80U) ? (word & low_above) : ((word & sign_bits) | low_above);
+        } else {
+            // 12-bit samples never reach the sign bit of a 16-bit lane
+            return ((word | sign_bits) - broadcast<T>(_threshold)) & sign_bits;
+        }
+    }
+
+    template <Edge EDGE, typename T>
+    size_t scan_edge(const T *buffer, const size_t end_index) {
+        constexpr size_t lanes{sizeof(uint32_t) / sizeof(T)};
+        constexpr size_t lane_bits{8 * sizeof(T)};
+        size_t index{_next_index};
+
+        if (lanes % _stride == 0) {
+            // Move to the first lane of this channel in a 32-bit word so the whole word is compared at once
+            while (index % lanes >= _stride && index < end_index) {
+                if (crossed<EDGE>(buffer[index])) return found(index);
+                index += _stride;
+            }
+
+            if (end_index / lanes > index / lanes) {
+                const size_t lane_offset{index % lanes};
+                uint32_t lane_mask{0};
+                for (size_t lane{lane_offset}; lane < lanes; lane += _stride) {
+                    lane_mask |= lane_sign_bits<T>() & (((uint32_t(1) << lane_bits) - 1) << (lane * lane_bits));
+                }
+
+                const uint32_t *word{reinterpret_cast<const uint32_t *>(&buffer[index - lane_offset])};
+                const uint32_t *const word_end{reinterpret_cast<const uint32_t *>(&buffer[end_index - end_index % lanes])};
+                for (; word != word_end; ++word) {
+                    if ((lanes_above<T>(*word) & lane_mask) != (_above ? lane_mask : 0U)) {
+                        const size_t word_index{static_cast<size_t>(reinterpret_cast<const T *>(word) - buffer)};
+                        for (size_t i{word_index + lane_offset}; i < word_index + lanes; i += _stride) {
+                            if (crossed<EDGE>(buffer[i])) return found(i);
+                        }
+                    }
+                }
+                index = end_index - end_index % lanes + lane_offset;
+            }
+        }
+
+        for (; index < end_index; index += _stride) {
+            if (crossed<EDGE>(buffer[index])) return found(index);
+        }
+        _next_index = index;
+        return no_trigger;
+    }
+
+    // Packed samples do not fill whole lanes of a word, every crossing is compared on its own
+    template <Edge EDGE>
+    size_t scan_edge(const dsp::Packed12View buffer, const size_t end_index) {
+        size_t index{_next_index};
+        for (; index < end_index; index += _stride) {
+            if (crossed<EDGE>(buffer[index])) return found(index);
+        }
+        _next_index = index;
+        return no_trigger;
+    }
+
+    size_t found(size_t index) {
+        _next_index = index + _stride;
+        return index;
+    }
+
+   private:
+    size_t _next_index;
+    size_t _stride;
+    uint16_t _threshold;
+    bool _above;
+    Edge _edge;
+
+    Type _type{Type::EDGE};
+    Condition _condition{Condition::LONGER};
+    State _state{State::IDLE};
+    float _samples_per_us{0.0f};
+    uint16_t _invert{0};
+    uint16_t _level{0}, _lower{0}, _upper{0}, _hysteresis{0};
+    uint32_t _time1{0}, _time2{0};
+    uint32_t _sample_count{0}, _start_count{0};
+
+    struct Qualifier {
+        uint8_t lane;
+        ChannelCondition condition;
+        bool above;
+    };
+    uint32_t _channel_mask{0};
+    uint _first_input{0};
+    Combination _combination{Combination::SINGLE};
+    Qualifier _qualifiers[3];
+    size_t _qualifier_count{0};
+    uint16_t _qualifier_level{0};
+    bool _qualifiers_valid{false}, _sequence_armed{false};
+    uint32_t _timeout{0}, _sequence_count{0};
 };
 }  // namespace trig
\ No newline at end of file
@@ -1,3 +1,4 @@
+#include <cstdio>
 #include "pico/stdlib.h"
 #include "posc_comms.hpp"
 #include "posc_dterminal_dynamic.hpp"
@@ -16,7 +17,11 @@ dt::StaticPart dtheader{3,
                         "\e[1EPinout:"
                         "\e[1E CH1 - GP26"
                         "\e[1E CH2 - GP27"
+                        "\e[1E CH3 - GP28"
+                        "\e[1E CH4 - GP29"
                         "\e[1E PWM - GP16"
+                        "\e[1E EXT - GP20"
+                        "\e[1E OUT - GP21"
                         "\e[2EVersion:\e[1E " PROJECT_VERSION "\e[1E " CMAKE_BUILD_TYPE "\e[1ECompiled:\e[1E " COMPILE_DATE
                         "\e[2ECreated by:\e[1E Vít Vaněček"
                         "\e[2E Czech\e[1E Technical\e[1E University\e[1E in Prague"
@@ -32,12 +37,18 @@ dt::StaticPart dtheader{3,
                         "ELAscope\e[5C\e[42m?\e[0m"
                         "\e[1E\e[42m<\e[0m  Sampling  \e[42m>\e[0m"};
 
-dt::MultiButton dtchannel_selector{2, 1, "ab", 0, comm::ansi::btn_pressed_str_green};
-dt::StaticPart dtchannel_selector_part{4,
-                                       "Channel:"
+dt::MultiButton dttrigger_channel_selector{11, 1, "efgh", 0, comm::ansi::btn_pressed_str_green};
+dt::DTButton dtchannel4_toggle{&dttrigger_channel_selector, 2, 4, 'd', false};
+dt::DTButton dtchannel3_toggle{&dtchannel4_toggle, 2, 3, 'c', false};
+dt::DTButton dtchannel2_toggle{&dtchannel3_toggle, 2, 2, 'b', false};
+dt::DTButton dtchannel1_toggle{&dtchannel2_toggle, 2, 1, 'a', true};
+dt::StaticPart dtchannel_selector_part{6,
+                                       "Channel:\e[2CTrig"
                                        "\e[1E\e[3CCH1"
-                                       "\e[1E\e[3CCH1+2",
-                                       &dtchannel_selector};
+                                       "\e[1E\e[3CCH2"
+                                       "\e[1E\e[3CCH3"
+                                       "\e[1E\e[3CCH4",
+                                       &dtchannel1_toggle};
 
 dt::FloatNumber dttrigger_level{1, 1, 1, 9, 0.5f, false};
 dt::StaticPart dttrigger_level_part{2,
@@ -57,32 +68,64 @@ dt::StaticPart dttrigger_selector_part{2,
                                        "\e[1E\e[3CFalling",
                                        &dttrigger_selector};
 
-dt::MultiButton dttrigger_mode_selector{2, 1, "wxyz", 0, comm::ansi::btn_pressed_str_green};
+dt::MultiButton dttrigger_mode_selector{2, 1, "wxyzvut", 0, comm::ansi::btn_pressed_str_green};
 dt::Strings dttrigger_mode{&dttrigger_mode_selector, 11, 0, dttmode_auto};
-dt::StaticPart dttrigger_mode_part{6,
+dt::StaticPart dttrigger_mode_part{9,
                                    "Mode:"
                                    "\e[1E\e[3CAUTO"
                                    "\e[1E\e[3CNORMAL"
                                    "\e[1E\e[3CSINGLE"
-                                   "\e[1E\e[3CPAUSE",
+                                   "\e[1E\e[3CPAUSE"
+                                   "\e[1E\e[3CROLL"
+                                   "\e[1E\e[3CSTREAM"
+                                   "\e[1E\e[3CRECORD",
                                    &dttrigger_mode};
 
 dt::MultiButton dtsamplerate_selector{2, 1, "BCDEFGHIJ", selector_samplerates_default, comm::ansi::btn_pressed_str_green};
-dt::StaticPart dtsamplerate_part{10,
-                                 one_channel_samplerate,
-                                 &dtsamplerate_selector};
+char samplerate_str[200];
+dt::StaticPart dtsamplerate_part{10, samplerate_str, 0, &dtsamplerate_selector};
 
 dt::FloatNumber dtsamplerate_disp{1, 1, 4, 14 - 4, adc::get_samplerate()};
 dt::StaticPart dtsamplerate_disp_part{3, "Freq (Hz):", &dtsamplerate_disp};
 
-dt::MultiButton dtsample_buff_selector{2, 1, "KLMNOPQ", selector_sample_size_default, comm::ansi::btn_pressed_str_green};
-dt::StaticPart dtsample_buff_part{9,
-                                  one_channel_sample_buff,
-                                  &dtsample_buff_selector};
+dt::FloatNumber dtdc_level{1, 1, 3, 14 - 3, 0.0f};
+dt::StaticPart dtdc_level_part{3, "DC (V):", &dtdc_level};
+
+dt::MultiButton dtsample_buff_selector{2, 1, "KLMNOPQR", selector_sample_size_default, comm::ansi::btn_pressed_str_green};
+char sample_buff_str[160];
+dt::StaticPart dtsample_buff_part{10, sample_buff_str, 0, &dtsample_buff_selector};
+
+dt::DTButton autoset_button{2, 0, 'S', false};
+dt::StaticPart autoset_button_part{1, "\e[3CAutoset", &autoset_button};
+
+dt::DTButton freeze_button{2, 0, 'T', false};
+dt::StaticPart freeze_button_part{1, "\e[3CFreeze", &freeze_button};
 
 constexpr dt::StaticPart* dterminal_parts[]{&dtheader,          &dtchannel_selector_part, &dttrigger_level_part,
                                             &dtpretrigger_part, &dttrigger_selector_part, &dttrigger_mode_part,
-                                            &dtsamplerate_part, &dtsamplerate_disp_part,  &dtsample_buff_part};
+                                            &dtsamplerate_part, &dtsamplerate_disp_part,  &dtdc_level_part,
+                                            &dtsample_buff_part, &autoset_button_part, &freeze_button_part};
+
+void set_channel_strings(size_t number_of_channels) {
+    number_of_channels = etl::clamp(number_of_channels, size_t(1), max_num_of_channels);
+
+    int length{snprintf(samplerate_str, sizeof(samplerate_str), "Samplerate:")};
+    for (const float samplerate : selector_samplerates) {
+        const float channel_samplerate{samplerate / number_of_channels};
+        if (channel_samplerate >= 1e3f) {
+            length += snprintf(&samplerate_str[length], sizeof(samplerate_str) - length, "\e[1E\e[3C%4.3g kHz", channel_samplerate / 1e3f);
+        } else {
+            length += snprintf(&samplerate_str[length], sizeof(samplerate_str) - length, "\e[1E\e[3C%4.3g Hz", channel_samplerate);
+        }
+    }
+    dtsamplerate_part.set_static_part({samplerate_str, static_cast<size_t>(length)});
+
+    length = snprintf(sample_buff_str, sizeof(sample_buff_str), "Samples:");
+    for (const size_t sample_size : selector_sample_size) {
+        length += snprintf(&sample_buff_str[length], sizeof(sample_buff_str) - length, "\e[1E\e[3C%6u", static_cast<unsigned>(sample_size / number_of_channels));
+    }
+    dtsample_buff_part.set_static_part({sample_buff_str, static_cast<size_t>(length)});
+}
 
 }  // namespace s0
 
@@ -91,7 +134,7 @@ dt::StaticPart dtheader{3,
                         "ELAscope\e[5C\e[42m?\e[0m"
                         "\e[1E\e[42m<\e[0m  ADC Freq  \e[42m>\e[0m"};
 
-PreciseFreq precise_adc_freq{"KJIHGFED", "kjihgfed", 73942, 50000000};
+PreciseFreq precise_adc_freq{"KJIHGFED", "kjihgfed", 1, 50000000};
 dt::IntNumber dtfreq_prec1{1, 2, 14, 2, 0, false};
 dt::IntNumber dtfreq_prec0{&dtfreq_prec1, 1, 2, 11, 6, 0, false};
 dt::StaticPart dtfreq_prec_part{5,
@@ -183,13 +226,308 @@ dt::StaticPart div_fract_toggle_part{1, "\e[3CFrac div", &div_fract_toggle};
 dt::DTButton div_ps_toggle{2, 0, 'b', false};
 dt::StaticPart div_pwr_toggle_part{1, "\e[3CPower save", &div_ps_toggle};
 
-constexpr dt::StaticPart* dterminal_parts[]{&dtheader, &div_fract_toggle_part, &div_pwr_toggle_part};
+dt::DTButton adc_8bit_toggle{2, 0, 'c', false};
+dt::StaticPart adc_8bit_toggle_part{1, "\e[3C8-bit ADC", &adc_8bit_toggle};
+
+dt::DTButton hires_toggle{2, 0, 'o', false};
+dt::StaticPart hires_toggle_part{1, "\e[3CHi-res", &hires_toggle};
+
+dt::DTButton packed_toggle{2, 0, 'F', false};
+dt::StaticPart packed_toggle_part{1, "\e[3CPacked 12-bit", &packed_toggle};
+
+dt::DTButton calibrate_button{2, 0, 'G', false};
+dt::StaticPart calibrate_button_part{1, "\e[3CCalibrate", &calibrate_button};
+
+dt::DTButton calibration_toggle{2, 0, 'H', false};
+dt::StaticPart calibration_toggle_part{1, "\e[3CCorrect ADC", &calibration_toggle};
+
+dt::DTButton gen_sync_toggle{2, 0, 'z', false};
+dt::StaticPart gen_sync_toggle_part{1, "\e[3CGen sync", &gen_sync_toggle};
+
+dt::MultiButton dtpeak_detect_selector{2, 1, "defg", peak_detect_pairs_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dtpeak_detect_selector_part{6,
+                                           "Peak detect:"
+                                           "\e[1E\e[3COff"
+                                           "\e[1E\e[3C 500 pairs"
+                                           "\e[1E\e[3C1000 pairs"
+                                           "\e[1E\e[3C2000 pairs",
+                                           &dtpeak_detect_selector};
+
+dt::MultiButton dtsegments_selector{2, 1, "hij", segment_counts_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dtsegments_selector_part{5,
+                                        "Segments:"
+                                        "\e[1E\e[3C 1"
+                                        "\e[1E\e[3C 8"
+                                        "\e[1E\e[3C32",
+                                        &dtsegments_selector};
+
+dt::MultiButton dtets_selector{2, 1, "klmn", ets_factors_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dtets_selector_part{6,
+                                   "Equiv. time:"
+                                   "\e[1E\e[3COff"
+                                   "\e[1E\e[3Cx10"
+                                   "\e[1E\e[3Cx20"
+                                   "\e[1E\e[3Cx40",
+                                   &dtets_selector};
+
+dt::MultiButton dtaverage_selector{2, 1, "pqrstu", average_counts_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dtaverage_selector_part{8,
+                                       "Average:"
+                                       "\e[1E\e[3COff"
+                                       "\e[1E\e[3C  x2"
+                                       "\e[1E\e[3C  x4"
+                                       "\e[1E\e[3C x16"
+                                       "\e[1E\e[3C x64"
+                                       "\e[1E\e[3Cx256",
+                                       &dtaverage_selector};
+
+dt::MultiButton dtdeep_selector{2, 1, "vwxy", deep_sample_counts_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dtdeep_selector_part{6,
+                                    "Deep capture:"
+                                    "\e[1E\e[3COff"
+                                    "\e[1E\e[3C 1M"
+                                    "\e[1E\e[3C 4M"
+                                    "\e[1E\e[3C16M",
+                                    &dtdeep_selector};
+
+dt::MultiButton dttarget_fps_selector{2, 1, "ABCDE", target_frame_rates_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dttarget_fps_selector_part{7,
+                                          "Adapt to fps:"
+                                          "\e[1E\e[3COff"
+                                          "\e[1E\e[3C 5"
+                                          "\e[1E\e[3C10"
+                                          "\e[1E\e[3C20"
+                                          "\e[1E\e[3C50",
+                                          &dttarget_fps_selector};
+
+constexpr dt::StaticPart* dterminal_parts[]{&dtheader,
+                                            &div_fract_toggle_part,
+                                            &div_pwr_toggle_part,
+                                            &adc_8bit_toggle_part,
+                                            &hires_toggle_part,
+                                            &packed_toggle_part,
+                                            &calibrate_button_part,
+                                            &calibration_toggle_part,
+                                            &gen_sync_toggle_part,
+                                            &dtpeak_detect_selector_part,
+                                            &dtsegments_selector_part,
+                                            &dtets_selector_part,
+                                            &dtaverage_selector_part,
+                                            &dtdeep_selector_part,
+                                            &dttarget_fps_selector_part};
 }  // namespace s3
 
+namespace s4 {
+dt::StaticPart dtheader{3,
+                        "ELAscope\e[5C\e[42m?\e[0m"
+                        "\e[1E\e[42m<\e[0m   Status   \e[42m>\e[0m"};
+
+dt::FloatNumber dtframerate{1, 1, 1, 14 - 2, 0.0f};
+dt::StaticPart dtframerate_part{3, "Frames/s:", &dtframerate};
+
+dt::FloatNumber dtblindtime{1, 1, 1, 14 - 2, 0.0f};
+dt::StaticPart dtblindtime_part{3, "Blind (%):", &dtblindtime};
+
+dt::IntNumber dtblindtime_us{1, 1, 14, 0, 0};
+dt::StaticPart dtblindtime_us_part{3, "Blind (us):", &dtblindtime_us};
+
+dt::IntNumber dtsegment_dead_time_us{1, 1, 14, 0, 0};
+dt::StaticPart dtsegment_dead_time_us_part{3, "Seg dead (us):", &dtsegment_dead_time_us};
+
+dt::FloatNumber dtcore1_idle{1, 1, 1, 14 - 2, 0.0f};
+dt::StaticPart dtcore1_idle_part{3, "C1 idle (%):", &dtcore1_idle};
+
+dt::FloatNumber dtstream_rate{1, 1, 1, 14 - 2, 0.0f};
+dt::StaticPart dtstream_rate_part{3, "Stream (kS/s):", &dtstream_rate};
+
+dt::IntNumber dtstream_lost{1, 1, 14, 0, 0};
+dt::StaticPart dtstream_lost_part{3, "Lost samples:", &dtstream_lost};
+
+dt::IntNumber dtsettings_latency_us{1, 1, 14, 0, 0};
+dt::StaticPart dtsettings_latency_us_part{3, "Settings (us):", &dtsettings_latency_us};
+
+dt::IntNumber dtframe_samples{1, 1, 14, 0, 0};
+dt::StaticPart dtframe_samples_part{3, "Frame samples:", &dtframe_samples};
+
+dt::FloatNumber dtlink_rate{1, 1, 1, 14 - 2, 0.0f};
+dt::StaticPart dtlink_rate_part{3, "Link (kS/s):", &dtlink_rate};
+
+dt::IntNumber dtfreeze_latency_us{1, 1, 14, 0, 0};
+dt::StaticPart dtfreeze_latency_us_part{3, "Freeze (us):", &dtfreeze_latency_us};
+
+constexpr dt::StaticPart* dterminal_parts[]{&dtheader,           &dtframerate_part,            &dtblindtime_part,  &dtblindtime_us_part,
+                                            &dtsegment_dead_time_us_part, &dtcore1_idle_part, &dtstream_rate_part, &dtstream_lost_part,
+                                            &dtsettings_latency_us_part,  &dtframe_samples_part, &dtlink_rate_part,  &dtfreeze_latency_us_part};
+}  // namespace s4
+
+namespace s5 {
+dt::StaticPart dtheader{3,
+                        "ELAscope\e[5C\e[42m?\e[0m"
+                        "\e[1E\e[42m<\e[0m  Trigger   \e[42m>\e[0m"};
+
+dt::DTButton ext_trigger_toggle{2, 0, 'A', false};
+dt::StaticPart ext_trigger_toggle_part{1, "\e[3CExternal", &ext_trigger_toggle};
+
+dt::MultiButton dttype_selector{2, 1, "abcde", trigger_types_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dttype_selector_part{7,
+                                    "Type:"
+                                    "\e[1E\e[3CEdge"
+                                    "\e[1E\e[3CPulse width"
+                                    "\e[1E\e[3CWindow"
+                                    "\e[1E\e[3CRunt"
+                                    "\e[1E\e[3CSlope",
+                                    &dttype_selector};
+
+dt::FloatNumber dtupper_level{1, 1, 1, 9, 2.5f, false};
+dt::StaticPart dtupper_level_part{2,
+                                  "Upper level:"
+                                  "\e[1E\e[5C\e[42m(-\e[3C\e[0mV\e[42m+)\e[0m",
+                                  &dtupper_level};
+
+dt::MultiButton dtcondition_selector{2, 1, "fgh", time_conditions_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dtcondition_selector_part{5,
+                                         "Width/slope:"
+                                         "\e[1E\e[3C> T1"
+                                         "\e[1E\e[3C< T1"
+                                         "\e[1E\e[3CT1 to T2",
+                                         &dtcondition_selector};
+
+dt::MultiButton dttime1_selector{2, 1, "ijklm", time1_values_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dttime1_selector_part{7,
+                                     "T1:"
+                                     "\e[1E\e[3C  1 us"
+                                     "\e[1E\e[3C 10 us"
+                                     "\e[1E\e[3C100 us"
+                                     "\e[1E\e[3C  1 ms"
+                                     "\e[1E\e[3C 10 ms",
+                                     &dttime1_selector};
+
+dt::MultiButton dttime2_selector{2, 1, "nopqr", time2_values_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dttime2_selector_part{7,
+                                     "T2:"
+                                     "\e[1E\e[3C 10 us"
+                                     "\e[1E\e[3C100 us"
+                                     "\e[1E\e[3C  1 ms"
+                                     "\e[1E\e[3C 10 ms"
+                                     "\e[1E\e[3C100 ms",
+                                     &dttime2_selector};
+
+dt::MultiButton dthysteresis_selector{2, 1, "stuv", hysteresis_values_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dthysteresis_selector_part{6,
+                                          "Hysteresis:"
+                                          "\e[1E\e[3COff"
+                                          "\e[1E\e[3C 50 mV"
+                                          "\e[1E\e[3C100 mV"
+                                          "\e[1E\e[3C200 mV",
+                                          &dthysteresis_selector};
+
+dt::MultiButton dtholdoff_selector{2, 1, "wxyz", holdoff_values_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dtholdoff_selector_part{6,
+                                       "Holdoff:"
+                                       "\e[1E\e[3COff"
+                                       "\e[1E\e[3C  1 ms"
+                                       "\e[1E\e[3C 10 ms"
+                                       "\e[1E\e[3C100 ms",
+                                       &dtholdoff_selector};
+
+constexpr dt::StaticPart* dterminal_parts[]{&dtheader,
+                                            &ext_trigger_toggle_part,
+                                            &dttype_selector_part,
+                                            &dtupper_level_part,
+                                            &dtcondition_selector_part,
+                                            &dttime1_selector_part,
+                                            &dttime2_selector_part,
+                                            &dthysteresis_selector_part,
+                                            &dtholdoff_selector_part};
+}  // namespace s5
+
+namespace s6 {
+dt::StaticPart dtheader{3,
+                        "ELAscope\e[5C\e[42m?\e[0m"
+                        "\e[1E\e[42m<\e[0m  Channels  \e[42m>\e[0m"};
+
+dt::MultiButton dtcombination_selector{2, 1, "abcd", combinations_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dtcombination_selector_part{6,
+                                           "Combine:"
+                                           "\e[1E\e[3CTrigger only"
+                                           "\e[1E\e[3CAND"
+                                           "\e[1E\e[3COR"
+                                           "\e[1E\e[3CTrigger, then",
+                                           &dtcombination_selector};
+
+dt::MultiButton dttimeout_selector{2, 1, "efgh", sequence_timeouts_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dttimeout_selector_part{6,
+                                       "Then within:"
+                                       "\e[1E\e[3C100 us"
+                                       "\e[1E\e[3C  1 ms"
+                                       "\e[1E\e[3C 10 ms"
+                                       "\e[1E\e[3C100 ms",
+                                       &dttimeout_selector};
+
+dt::FloatNumber dtqualifier_level{1, 1, 1, 9, 1.6f, false};
+dt::StaticPart dtqualifier_level_part{2,
+                                      "Channel level:"
+                                      "\e[1E\e[5C\e[42m(-\e[3C\e[0mV\e[42m+)\e[0m",
+                                      &dtqualifier_level};
+
+dt::MultiButton dtch1_condition_selector{2, 1, "ABCDE", channel_conditions_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dtch1_condition_selector_part{7,
+                                             "CH1:"
+                                             "\e[1E\e[3CAny"
+                                             "\e[1E\e[3CHigh"
+                                             "\e[1E\e[3CLow"
+                                             "\e[1E\e[3CRising"
+                                             "\e[1E\e[3CFalling",
+                                             &dtch1_condition_selector};
+
+dt::MultiButton dtch2_condition_selector{2, 1, "FGHIJ", channel_conditions_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dtch2_condition_selector_part{7,
+                                             "CH2:"
+                                             "\e[1E\e[3CAny"
+                                             "\e[1E\e[3CHigh"
+                                             "\e[1E\e[3CLow"
+                                             "\e[1E\e[3CRising"
+                                             "\e[1E\e[3CFalling",
+                                             &dtch2_condition_selector};
+
+dt::MultiButton dtch3_condition_selector{2, 1, "KLMNO", channel_conditions_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dtch3_condition_selector_part{7,
+                                             "CH3:"
+                                             "\e[1E\e[3CAny"
+                                             "\e[1E\e[3CHigh"
+                                             "\e[1E\e[3CLow"
+                                             "\e[1E\e[3CRising"
+                                             "\e[1E\e[3CFalling",
+                                             &dtch3_condition_selector};
+
+dt::MultiButton dtch4_condition_selector{2, 1, "PQRST", channel_conditions_default, comm::ansi::btn_pressed_str_green};
+dt::StaticPart dtch4_condition_selector_part{7,
+                                             "CH4:"
+                                             "\e[1E\e[3CAny"
+                                             "\e[1E\e[3CHigh"
+                                             "\e[1E\e[3CLow"
+                                             "\e[1E\e[3CRising"
+                                             "\e[1E\e[3CFalling",
+                                             &dtch4_condition_selector};
+
+constexpr dt::StaticPart* dterminal_parts[]{&dtheader,
+                                            &dtcombination_selector_part,
+                                            &dttimeout_selector_part,
+                                            &dtqualifier_level_part,
+                                            &dtch1_condition_selector_part,
+                                            &dtch2_condition_selector_part,
+                                            &dtch3_condition_selector_part,
+                                            &dtch4_condition_selector_part};
+}  // namespace s6
+
 void init_dterminal() {
+    s0::set_channel_strings(1);
     init_dterminal_base(dterminal, sh::dterminal_parts, sh::index);
     init_dterminal_base(dterminal, s0::dterminal_parts, s0::index);
     init_dterminal_base(dterminal, s1::dterminal_parts, s1::index);
     init_dterminal_base(dterminal, s2::dterminal_parts, s2::index);
     init_dterminal_base(dterminal, s3::dterminal_parts, s3::index);
+    init_dterminal_base(dterminal, s4::dterminal_parts, s4::index);
+    init_dterminal_base(dterminal, s5::dterminal_parts, s5::index);
+    init_dterminal_base(dterminal, s6::dterminal_parts, s6::index);
 }
@@ -24,8 +24,13 @@ namespace s0 {
 inline constexpr uint8_t index{dt::Terminal::start_screen};
 inline constexpr trig::Settings::Edge selector_edges[]{trig::Settings::Edge::RISING, trig::Settings::Edge::FALLING};
 
-extern dt::MultiButton dtchannel_selector;
-inline constexpr size_t max_num_of_channels{2};
+inline constexpr size_t max_num_of_channels{adc::max_channels};
+extern dt::DTButton dtchannel1_toggle;
+extern dt::DTButton dtchannel2_toggle;
+extern dt::DTButton dtchannel3_toggle;
+extern dt::DTButton dtchannel4_toggle;
+inline constexpr dt::DTButton *channel_toggles[max_num_of_channels]{&dtchannel1_toggle, &dtchannel2_toggle, &dtchannel3_toggle, &dtchannel4_toggle};
+extern dt::MultiButton dttrigger_channel_selector;
 
 extern dt::FloatNumber dttrigger_level;
 
@@ -36,6 +41,9 @@ inline constexpr char dttmode_auto[]{"\e[48;5;31mAUTO\e[0m"};
 inline constexpr char dttmode_norm[]{"\e[48;5;31mNORM\e[0m"};
 inline constexpr char dttmode_wait[]{"\e[48;5;160mWAIT\e[0m"};
 inline constexpr char dttmode_hold[]{"\e[48;5;164mHOLD\e[0m"};
+inline constexpr char dttmode_roll[]{"\e[48;5;31mROLL\e[0m"};
+inline constexpr char dttmode_stream[]{"\e[48;5;31mSTRM\e[0m"};
+inline constexpr char dttmode_record[]{"\e[48;5;160mREC \e[0m"};
 extern dt::Strings dttrigger_mode;
 extern dt::MultiButton dttrigger_mode_selector;
 
@@ -44,59 +52,26 @@ inline constexpr size_t selector_samplerates_default{8};
 extern dt::MultiButton dtsamplerate_selector;
 extern dt::StaticPart dtsamplerate_part;
 extern dt::FloatNumber dtsamplerate_disp;
+extern dt::FloatNumber dtdc_level;
 
-inline constexpr char one_channel_samplerate[]{
-    "Samplerate:"
-    "\e[1E\e[3C  1 kHz"
-    "\e[1E\e[3C  2 kHz"
-    "\e[1E\e[3C  5 kHz"
-    "\e[1E\e[3C 10 kHz"
-    "\e[1E\e[3C 20 kHz"
-    "\e[1E\e[3C 50 kHz"
-    "\e[1E\e[3C100 kHz"
-    "\e[1E\e[3C200 kHz"
-    "\e[1E\e[3C500 kHz"};
-inline constexpr char two_channel_samplerate[]{
-    "Samplerate:"
-    "\e[1E\e[3C0.5 kHz"
-    "\e[1E\e[3C  1 kHz"
-    "\e[1E\e[3C2.5 kHz"
-    "\e[1E\e[3C  5 kHz"
-    "\e[1E\e[3C 10 kHz"
-    "\e[1E\e[3C 25 kHz"
-    "\e[1E\e[3C 50 kHz"
-    "\e[1E\e[3C100 kHz"
-    "\e[1E\e[3C250 kHz"};
-
-inline constexpr etl::array<etl::string_view, max_num_of_channels> channel_samplerate_strs{one_channel_samplerate, two_channel_samplerate};
-
-inline constexpr size_t selector_sample_size[]{1000, 2000, 5000, 10000, 20000, 50000, 100000};
+inline constexpr size_t selector_sample_size[]{1000, 2000, 5000, 10000, 20000, 50000, 100000, 200000};
 inline constexpr size_t selector_sample_size_default{0};
 extern dt::MultiButton dtsample_buff_selector;
 
-inline constexpr char one_channel_sample_buff[]{
-    "Samples:"
-    "\e[1E\e[3C  1000"
-    "\e[1E\e[3C  2000"
-    "\e[1E\e[3C  5000"
-    "\e[1E\e[3C 10000"
-    "\e[1E\e[3C 20000"
-    "\e[1E\e[3C 50000"
-    "\e[1E\e[3C100000"};
-inline constexpr char two_channel_sample_buff[]{
-    "Samples:"
-    "\e[1E\e[3C   500"
-    "\e[1E\e[3C  1000"
-    "\e[1E\e[3C  2000"
-    "\e[1E\e[3C  5000"
-    "\e[1E\e[3C 10000"
-    "\e[1E\e[3C 20000"
-    "\e[1E\e[3C 50000"};
-inline constexpr etl::array<etl::string_view, max_num_of_channels> channel_sample_buff_strs{one_channel_sample_buff, two_channel_sample_buff};
-
 extern dt::StaticPart dtsample_buff_part;
 
-inline constexpr dt::MultiButton *selector_array[]{&dtchannel_selector, &dttrigger_selector, &dtsamplerate_selector, &dttrigger_mode_selector,
+// Autoset stays pressed until Core1 has measured the trigger channel, the frame then holds about autoset_periods
+extern dt::DTButton autoset_button;
+inline constexpr float autoset_periods{5.0f};
+
+// Stop event of the flight recorder, the host can send freeze_command on any screen instead
+extern dt::DTButton freeze_button;
+inline constexpr char freeze_command{'*'};
+
+// Samplerates and sample counts are shown per channel
+void set_channel_strings(size_t number_of_channels);
+
+inline constexpr dt::MultiButton *selector_array[]{&dttrigger_channel_selector, &dttrigger_selector, &dtsamplerate_selector, &dttrigger_mode_selector,
                                                    &dtsample_buff_selector};
 }  // namespace s0
 
@@ -144,9 +119,133 @@ inline constexpr uint8_t index{dt::Terminal::start_screen + 3};
 
 extern dt::DTButton div_fract_toggle;
 extern dt::DTButton div_ps_toggle;
+extern dt::DTButton adc_8bit_toggle;
+extern dt::DTButton hires_toggle;
+extern dt::DTButton packed_toggle;
+// Calibrate stays pressed while the inputs are measured, Correct ADC applies the stored table to sent frames
+extern dt::DTButton calibrate_button;
+extern dt::DTButton calibration_toggle;
+extern dt::DTButton gen_sync_toggle;
+
+// Number of min/max pairs per channel sent to the host, 0 sends every sample
+inline constexpr size_t peak_detect_pairs[]{0, 500, 1000, 2000};
+inline constexpr size_t peak_detect_pairs_default = 0;
+extern dt::MultiButton dtpeak_detect_selector;
+
+// Trigger events captured back to back before the batch is sent
+inline constexpr size_t segment_counts[]{1, 8, 32};
+inline constexpr size_t segment_counts_default = 0;
+extern dt::MultiButton dtsegments_selector;
+
+// Equivalent-time sampling of repetitive signals, effective samplerate is factor times the ADC one
+inline constexpr uint32_t ets_factors[]{1, 10, 20, 40};
+inline constexpr size_t ets_factors_default = 0;
+extern dt::MultiButton dtets_selector;
+
+// Triggered acquisitions averaged on the device before the frame is sent
+inline constexpr uint32_t average_counts[]{1, 2, 4, 16, 64, 256};
+inline constexpr size_t average_counts_default = 0;
+extern dt::MultiButton dtaverage_selector;
+
+// Triggered captures longer than the buffer, sent while they are acquired
+inline constexpr uint32_t deep_sample_counts[]{0, 1000000, 4000000, 16000000};
+inline constexpr size_t deep_sample_counts_default = 0;
+extern dt::MultiButton dtdeep_selector;
+
+// Frames per second the number of samples is adapted to, 0 sends the selected buffer
+inline constexpr float target_frame_rates[]{0.0f, 5.0f, 10.0f, 20.0f, 50.0f};
+inline constexpr size_t target_frame_rates_default = 0;
+extern dt::MultiButton dttarget_fps_selector;
+
+inline constexpr dt::MultiButton *selector_array[]{&dtpeak_detect_selector, &dtsegments_selector, &dtets_selector,
+                                                   &dtaverage_selector,     &dtdeep_selector,     &dttarget_fps_selector};
 
 }  // namespace s3
 
+namespace s4 {
+inline constexpr uint8_t index{dt::Terminal::start_screen + 4};
+
+extern dt::FloatNumber dtframerate;
+extern dt::FloatNumber dtblindtime;
+extern dt::IntNumber dtblindtime_us;
+extern dt::IntNumber dtsegment_dead_time_us;
+extern dt::FloatNumber dtcore1_idle;
+extern dt::FloatNumber dtstream_rate;
+extern dt::IntNumber dtstream_lost;
+extern dt::IntNumber dtsettings_latency_us;
+extern dt::IntNumber dtframe_samples;
+extern dt::FloatNumber dtlink_rate;
+extern dt::IntNumber dtfreeze_latency_us;
+}  // namespace s4
+
+namespace s5 {
+inline constexpr uint8_t index{dt::Terminal::start_screen + 5};
+
+// Trigger input pin replaces the trigger channel
+extern dt::DTButton ext_trigger_toggle;
+
+inline constexpr trig::Settings::Type trigger_types[]{trig::Settings::Type::EDGE, trig::Settings::Type::PULSE_WIDTH, trig::Settings::Type::WINDOW,
+                                                      trig::Settings::Type::RUNT, trig::Settings::Type::SLOPE};
+inline constexpr size_t trigger_types_default = 0;
+extern dt::MultiButton dttype_selector;
+
+inline constexpr trig::Settings::Condition time_conditions[]{trig::Settings::Condition::LONGER, trig::Settings::Condition::SHORTER,
+                                                             trig::Settings::Condition::IN_RANGE};
+inline constexpr size_t time_conditions_default = 0;
+extern dt::MultiButton dtcondition_selector;
+
+// Pulse width and slope time limits
+inline constexpr uint32_t time1_values_us[]{1, 10, 100, 1000, 10000};
+inline constexpr size_t time1_values_default = 1;
+extern dt::MultiButton dttime1_selector;
+
+inline constexpr uint32_t time2_values_us[]{10, 100, 1000, 10000, 100000};
+inline constexpr size_t time2_values_default = 1;
+extern dt::MultiButton dttime2_selector;
+
+inline constexpr uint16_t hysteresis_values_mV[]{0, 50, 100, 200};
+inline constexpr size_t hysteresis_values_default = 0;
+extern dt::MultiButton dthysteresis_selector;
+
+inline constexpr uint32_t holdoff_values_us[]{0, 1000, 10000, 100000};
+inline constexpr size_t holdoff_values_default = 0;
+extern dt::MultiButton dtholdoff_selector;
+
+extern dt::FloatNumber dtupper_level;
+
+inline constexpr dt::MultiButton *selector_array[]{&dttype_selector, &dtcondition_selector, &dttime1_selector, &dttime2_selector, &dthysteresis_selector,
+                                                   &dtholdoff_selector};
+}  // namespace s5
+
+namespace s6 {
+inline constexpr uint8_t index{dt::Terminal::start_screen + 6};
+
+inline constexpr trig::Settings::Combination combinations[]{trig::Settings::Combination::SINGLE, trig::Settings::Combination::AND,
+                                                            trig::Settings::Combination::OR, trig::Settings::Combination::SEQUENCE};
+inline constexpr size_t combinations_default = 0;
+extern dt::MultiButton dtcombination_selector;
+
+inline constexpr uint32_t sequence_timeouts_us[]{100, 1000, 10000, 100000};
+inline constexpr size_t sequence_timeouts_default = 1;
+extern dt::MultiButton dttimeout_selector;
+
+inline constexpr trig::Settings::ChannelCondition channel_conditions[]{trig::Settings::ChannelCondition::ANY, trig::Settings::ChannelCondition::HIGH,
+                                                                       trig::Settings::ChannelCondition::LOW, trig::Settings::ChannelCondition::RISING,
+                                                                       trig::Settings::ChannelCondition::FALLING};
+inline constexpr size_t channel_conditions_default = 0;
+extern dt::MultiButton dtch1_condition_selector;
+extern dt::MultiButton dtch2_condition_selector;
+extern dt::MultiButton dtch3_condition_selector;
+extern dt::MultiButton dtch4_condition_selector;
+
+extern dt::FloatNumber dtqualifier_level;
+
+inline constexpr dt::MultiButton *channel_selector_array[]{&dtch1_condition_selector, &dtch2_condition_selector, &dtch3_condition_selector,
+                                                           &dtch4_condition_selector};
+inline constexpr dt::MultiButton *selector_array[]{&dtcombination_selector,   &dttimeout_selector,       &dtch1_condition_selector,
+                                                   &dtch2_condition_selector, &dtch3_condition_selector, &dtch4_condition_selector};
+}  // namespace s6
+
 template <size_t ARRAY_SIZE>
 dt::MultiButton *get_pressed_selector(signed char rx_char, dt::MultiButton *const (&selector_array)[ARRAY_SIZE]) {
     int selector_index;
@@ -158,6 +257,16 @@ dt::MultiButton *get_pressed_selector(signed char rx_char, dt::MultiButton *cons
     return nullptr;
 }
 
+template <size_t ARRAY_SIZE>
+dt::DTButton *get_pressed_toggle(signed char rx_char, dt::DTButton *const (&toggle_array)[ARRAY_SIZE]) {
+    for (dt::DTButton *toggle : toggle_array) {
+        if (toggle->get_button_char() == rx_char) {
+            return toggle;
+        }
+    }
+    return nullptr;
+}
+
 template <size_t ARRAY_SIZE>
 void init_dterminal_base(dt::Terminal &dterminal, dt::StaticPart *const (&dterminal_parts)[ARRAY_SIZE], uint8_t screen = 0) {
     dterminal.set_screen(screen);